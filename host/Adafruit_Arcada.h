@@ -0,0 +1,94 @@
+// Host stand-in for Adafruit_Arcada. The display is an in-memory panel
+// that receives pixels through the same address-window interface as the
+// real SPI TFT, so anything blitted to it can be inspected or dumped.
+#ifndef HOST_ADAFRUIT_ARCADA_H
+#define HOST_ADAFRUIT_ARCADA_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include <atomic>
+
+#ifndef HOST_TFT_WIDTH
+#define HOST_TFT_WIDTH 240
+#endif
+
+#ifndef HOST_TFT_HEIGHT
+#define HOST_TFT_HEIGHT 240
+#endif
+
+#define ARCADA_BUTTONMASK_A 0x01
+#define ARCADA_BUTTONMASK_B 0x02
+
+struct HostDma;
+
+// writePixels with block = false hands the transfer to a worker thread
+// standing in for the SPI DMA engine, so drawing overlaps it just as it
+// does on the device. Like the real driver only one transfer is in flight
+// at a time, and the address window must not change until it finishes.
+class Adafruit_SPITFT : public Adafruit_GFX {
+public:
+    Adafruit_SPITFT(uint16_t w, uint16_t h);
+    ~Adafruit_SPITFT();
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+
+    void startWrite() override {}
+    void endWrite() override {}
+    void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    void writePixels(uint16_t *colors, uint32_t len, bool block = true, bool bigEndian = false);
+    void dmaWait();
+    bool dmaBusy() const;
+
+    // Host only: the pixels currently shown on the glass.
+    const uint16_t *panel() const { return _panel; }
+
+    // Host only: pixels pushed through writePixels since the last reset.
+    uint32_t pixelsSent;
+    uint32_t windowsSent;
+
+    // Host only: misuse of the DMA engine seen so far. dmaTorn counts
+    // transfers whose source pixels changed while they were in flight;
+    // dmaOrderErrors counts address window changes made while a transfer
+    // was still running. dmaTorn is counted on the DMA worker thread.
+    std::atomic<uint32_t> dmaTorn;
+    uint32_t dmaOrderErrors;
+
+private:
+    void send(const uint16_t *colors, uint32_t len, bool bigEndian);
+
+    HostDma *_dma;
+    uint16_t *_panel;
+    int16_t _winX, _winY, _winW, _winH;
+    uint32_t _winCursor;
+};
+
+class Adafruit_Arcada {
+public:
+    Adafruit_Arcada();
+
+    bool arcadaBegin();
+    void displayBegin();
+    void setBacklight(uint8_t brightness, bool saveToDisk = false);
+
+    bool createFrameBuffer(uint16_t width, uint16_t height);
+    bool blitFrameBuffer(uint16_t x, uint16_t y, bool blocking = false, bool bigEndian = false, Adafruit_SPITFT *display = NULL);
+    uint16_t *getFrameBuffer() { return _canvas == NULL ? NULL : _canvas->getBuffer(); }
+    GFXcanvas16 *getCanvas() { return _canvas; }
+
+    uint32_t readButtons();
+
+    Adafruit_SPITFT *display;
+
+private:
+    GFXcanvas16 *_canvas;
+};
+
+// Host only: button bits returned by the next readButtons calls.
+extern uint32_t host_buttons;
+
+// Host only: how long the simulated SPI bus takes per pixel, in
+// nanoseconds. Blocking and DMA writes both take this long. Zero makes
+// transfers instant.
+extern uint32_t host_spi_ns_per_pixel;
+
+#endif
@@ -0,0 +1,5 @@
+// Host stand-in: Adafruit_GFX.h includes the BusIO headers but the canvas
+// code used on the host does not need anything from them.
+#ifndef HOST_ADAFRUIT_SPIDEVICE_H
+#define HOST_ADAFRUIT_SPIDEVICE_H
+#endif
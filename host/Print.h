@@ -0,0 +1,37 @@
+// Host stand-in for the Arduino Print class.
+#ifndef HOST_PRINT_H
+#define HOST_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (size--) {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+
+    size_t write(const char *str) {
+        return str == nullptr ? 0 : write((const uint8_t *) str, strlen(str));
+    }
+
+    size_t print(const char *str) { return write(str); }
+    size_t print(char c) { return write((uint8_t) c); }
+    size_t print(int n, int base = 10) { return print((long) n, base); }
+    size_t print(unsigned int n, int base = 10) { return print((unsigned long) n, base); }
+    size_t print(long n, int base = 10);
+    size_t print(unsigned long n, int base = 10);
+    size_t print(double f, int digits = 2);
+    size_t println(const char *str) { return print(str) + write((uint8_t) '\n'); }
+};
+
+#endif
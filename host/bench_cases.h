@@ -0,0 +1,357 @@
+// The cases of the runtime microbenchmark suite, shared by the host
+// runner (bench_suite.cpp) and the device runner (sketch/bench). Include
+// it after the generated sketch. Each case repeats one operation of the
+// runtime or the standard library a given number of times on inputs of a
+// given size and returns a checksum of the results, so that the work
+// cannot be optimised away and so that a change in behaviour shows up
+// next to a change in speed. The runners only differ in their clock:
+// nanoseconds from steady_clock on the host, DWT cycles on Cortex-M.
+//
+// runAll() writes the results as JSON, one case per line in a fixed
+// order, with every number an integer so that the output is the same
+// whatever printf supports. per_op_milli is the time of one operation
+// in thousandths of a clock tick, from the fastest of JUN_BENCH_RUNS
+// runs. The sizes are list lengths unless a case says otherwise, and are
+// smaller on the device so that the lists fit its stack.
+#ifndef BENCH_CASES_H
+#define BENCH_CASES_H
+
+#ifndef JUN_BENCH_RUNS
+#define JUN_BENCH_RUNS 5
+#endif
+
+// Element operations per timed run, divided between the iterations
+#ifdef __arm__
+#ifndef JUN_BENCH_WORK
+#define JUN_BENCH_WORK 65536
+#endif
+#define JUN_BENCH_SMALL 8
+#define JUN_BENCH_MEDIUM 64
+#define JUN_BENCH_LARGE 256
+#else
+#ifndef JUN_BENCH_WORK
+#define JUN_BENCH_WORK 1048576
+#endif
+#define JUN_BENCH_SMALL 16
+#define JUN_BENCH_MEDIUM 256
+#define JUN_BENCH_LARGE 4096
+#endif
+
+namespace bench
+{
+    template<typename T, int n>
+    using list = Prelude::list<T, n>;
+
+    typedef uint32_t (*clock)();
+
+    // work is the element operations in one iteration, which the
+    // iterations are chosen by
+    struct benchCase {
+        const char *name;
+        uint32_t size;
+        uint32_t work;
+        uint32_t (*run)(uint32_t iterations);
+    };
+
+    constexpr uint32_t linear(uint32_t n) {
+        return n;
+    }
+
+    constexpr uint32_t log2(uint32_t n) {
+        return n <= 1 ? 0 : 1 + log2(n / 2);
+    }
+
+    constexpr uint32_t nLogN(uint32_t n) {
+        return n * log2(n);
+    }
+
+    // Makes the compiler assume the memory at ptr is read, so that a
+    // result that is only copied is still made
+    inline void escape(const void *ptr) {
+        __asm__ volatile("" : : "r"(ptr) : "memory");
+    }
+
+    // A list of length n holding a scrambled permutation of 0 to n - 1
+    template<int n>
+    list<int32_t, n> scrambled() {
+        list<int32_t, n> lst = List::replicate<int32_t, n>(n, 0);
+        for (uint32_t i = 0; i < (uint32_t) n; i++) {
+            lst.data[i] = (int32_t) ((i * 2654435761u) % n);
+        }
+        return lst;
+    }
+
+    inline int32_t addOne(int32_t x) {
+        return x + 1;
+    }
+
+    inline int32_t add(int32_t x, int32_t total) {
+        return x + total;
+    }
+
+    inline int32_t identity(int32_t x) {
+        return x;
+    }
+
+    // A list of n elements as a variant's first alternative, or a scalar
+    template<int n>
+    using payload = juniper::variant<list<int32_t, n>, uint32_t>;
+
+    template<int n>
+    uint32_t variantCopy(uint32_t iterations) {
+        static payload<n> a = payload<n>::template create<0>(scrambled<n>());
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            payload<n> b(a);
+            escape(&b);
+            sum += b.template get<0>().data[i % n];
+        }
+        return sum;
+    }
+
+    // Assigns a list and a scalar in turn, so that every assignment
+    // changes the alternative held
+    template<int n>
+    uint32_t variantAssign(uint32_t iterations) {
+        static payload<n> values[2] = {
+            payload<n>::template create<0>(scrambled<n>()),
+            payload<n>::template create<1>(7)
+        };
+        payload<n> b;
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            b = values[i & 1];
+            escape(&b);
+            sum += b.id();
+        }
+        return sum;
+    }
+
+    // Copying a reference and dropping it again, size 1
+    template<typename Cell>
+    uint32_t sharedCopy(uint32_t iterations) {
+        Cell cell(3);
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            Cell copy(cell);
+            escape(&copy);
+            sum += *copy.get();
+        }
+        return sum;
+    }
+
+    template<int n>
+    uint32_t listMap(uint32_t iterations) {
+        static const list<int32_t, n> input = scrambled<n>();
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            list<int32_t, n> out = List::map<int32_t, void, int32_t, n>(juniper::function<void, int32_t(int32_t)>(addOne), input);
+            escape(&out);
+            sum += out.data[i % n];
+        }
+        return sum;
+    }
+
+    template<int n>
+    uint32_t listFold(uint32_t iterations) {
+        static const list<int32_t, n> input = scrambled<n>();
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            sum += List::fold<int32_t, void, int32_t, n>(juniper::function<void, int32_t(int32_t, int32_t)>(add), (int32_t) i, input);
+        }
+        return sum;
+    }
+
+    // Sorts a fresh copy each time, so the copy is part of the time
+    template<int n>
+    uint32_t listSort(uint32_t iterations) {
+        static const list<int32_t, n> input = scrambled<n>();
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            list<int32_t, n> lst = input;
+            List::sort<int32_t, void, int32_t, n>(juniper::function<void, int32_t(int32_t)>(identity), lst);
+            sum += lst.data[i % n];
+        }
+        return sum;
+    }
+
+    // Two lists of n / 2 into one of capacity n
+    template<int n>
+    uint32_t listConcat(uint32_t iterations) {
+        static const list<int32_t, n / 2> half = scrambled<n / 2>();
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            list<int32_t, n> out = List::concat<int32_t, n / 2, n / 2, n>(half, half);
+            escape(&out);
+            sum += out.data[i % n] + out.length;
+        }
+        return sum;
+    }
+
+    // size 1
+    inline uint32_t signalMap(uint32_t iterations) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            Prelude::sig<int32_t> s = Prelude::signal<int32_t>(Prelude::just<int32_t>((int32_t) i));
+            Prelude::sig<int32_t> out = Signal::map<int32_t, void, int32_t>(juniper::function<void, int32_t(int32_t)>(addOne), s);
+            sum += out.signal().just();
+        }
+        return sum;
+    }
+
+    // size 1
+    inline uint32_t signalFoldP(uint32_t iterations) {
+        int32_t state = 0;
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            Prelude::sig<int32_t> s = Prelude::signal<int32_t>(Prelude::just<int32_t>((int32_t) i));
+            Prelude::sig<int32_t> out = Signal::foldP<int32_t, void, int32_t>(juniper::function<void, int32_t(int32_t, int32_t)>(add), state, s);
+            sum += out.signal().just();
+        }
+        return sum;
+    }
+
+    // n signals of which only the last has a value, the longest search
+    template<int n>
+    uint32_t signalMergeMany(uint32_t iterations) {
+        static list<Prelude::sig<int32_t>, n> sigs = List::replicate<Prelude::sig<int32_t>, n>(n, Prelude::signal<int32_t>(Prelude::nothing<int32_t>()));
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            sigs.data[n - 1] = Prelude::signal<int32_t>(Prelude::just<int32_t>((int32_t) i));
+            sum += Signal::mergeMany<int32_t, n>(sigs).signal().just();
+        }
+        return sum;
+    }
+
+    // The size is the number of characters printed
+    template<int32_t value>
+    uint32_t charListI32(uint32_t iterations) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            Prelude::charlist<11> s = CharList::i32ToCharList<11>(value ^ (int32_t) (i & 1));
+            escape(&s);
+            sum += s.length + s.data[i % 4];
+        }
+        return sum;
+    }
+
+    // n copies of c and the terminating zero
+    template<int n>
+    Prelude::charlist<n> filledCharList(uint8_t c) {
+        juniper::array<uint8_t, n + 1> chars;
+        chars.fill(c);
+        chars[n] = 0;
+        return Prelude::charlist<n>(chars, n + 1);
+    }
+
+    // Two strings of n characters; the size is n
+    template<int n>
+    uint32_t charListSafeConcat(uint32_t iterations) {
+        static Prelude::charlist<n> s = filledCharList<n>('a');
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            Prelude::charlist<n + n> out = CharList::safeConcat<n, n>(s, s);
+            escape(&out);
+            sum += out.length + out.data[i % (n + n)];
+        }
+        return sum;
+    }
+
+    // size 1
+    inline uint32_t colorHsvToRgb(uint32_t iterations) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            Color::rgb c = Color::hsvToRgb(Color::hsv((float) (i % 360), 0.75f, 0.5f));
+            sum += c.r + c.g + c.b;
+        }
+        return sum;
+    }
+
+    // size 1
+    inline uint32_t colorRgbToRgb565(uint32_t iterations) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < iterations; i++) {
+            sum += Color::rgbToRgb565(Color::rgb((uint8_t) i, (uint8_t) (i >> 3), (uint8_t) (i >> 6)));
+        }
+        return sum;
+    }
+
+#define JUN_BENCH_SIZED(name, run, work) \
+    { name, JUN_BENCH_SMALL, work(JUN_BENCH_SMALL), run<JUN_BENCH_SMALL> }, \
+    { name, JUN_BENCH_MEDIUM, work(JUN_BENCH_MEDIUM), run<JUN_BENCH_MEDIUM> }, \
+    { name, JUN_BENCH_LARGE, work(JUN_BENCH_LARGE), run<JUN_BENCH_LARGE> }
+
+    // New cases go at the end, so that results stay in the same order
+    const benchCase cases[] = {
+        JUN_BENCH_SIZED("variant.copy", variantCopy, linear),
+        JUN_BENCH_SIZED("variant.assign", variantAssign, linear),
+        { "shared_ptr.copy", 1, 1, sharedCopy<juniper::refcell<int32_t>> },
+        { "shared_ptr.copy_atomic", 1, 1, sharedCopy<juniper::atomic_refcell<int32_t>> },
+        JUN_BENCH_SIZED("List::map", listMap, linear),
+        JUN_BENCH_SIZED("List::fold", listFold, linear),
+        JUN_BENCH_SIZED("List::sort", listSort, nLogN),
+        JUN_BENCH_SIZED("List::concat", listConcat, linear),
+        { "Signal::map", 1, 1, signalMap },
+        { "Signal::foldP", 1, 1, signalFoldP },
+        JUN_BENCH_SIZED("Signal::mergeMany", signalMergeMany, linear),
+        { "CharList::i32ToCharList", 1, 1, charListI32<7> },
+        { "CharList::i32ToCharList", 5, 5, charListI32<12345> },
+        { "CharList::i32ToCharList", 11, 11, charListI32<-2000000000> },
+        { "CharList::safeConcat", 8, 8, charListSafeConcat<8> },
+        { "CharList::safeConcat", 64, 64, charListSafeConcat<64> },
+        { "Color::hsvToRgb", 1, 1, colorHsvToRgb },
+        { "Color::rgbToRgb565", 1, 1, colorRgbToRgb565 }
+    };
+
+#undef JUN_BENCH_SIZED
+
+    const size_t caseCount = sizeof(cases) / sizeof(cases[0]);
+
+    struct result {
+        uint32_t iterations;
+        uint32_t ticks;
+        uint32_t checksum;
+    };
+
+    // The fastest of JUN_BENCH_RUNS runs, after one to warm up and to
+    // build the case's inputs
+    inline result measure(const benchCase& c, clock now) {
+        result r;
+        r.iterations = JUN_BENCH_WORK / c.work > 0 ? JUN_BENCH_WORK / c.work : 1;
+        c.run(1);
+        for (int run = 0; run < JUN_BENCH_RUNS; run++) {
+            uint32_t start = now();
+            r.checksum = c.run(r.iterations);
+            // Unsigned subtraction survives the counter wrapping
+            uint32_t ticks = now() - start;
+            r.ticks = run == 0 || ticks < r.ticks ? ticks : r.ticks;
+        }
+        return r;
+    }
+
+    // Runs every case whose name starts with only (all of them when it is
+    // empty) and writes the results through emit, a line at a time
+    inline void runAll(clock now, const char *unit, const char *only, void (*emit)(const char *line)) {
+        char line[160];
+        snprintf(line, sizeof(line), "{\n  \"suite\": \"juniper-runtime\",\n  \"schema\": 1,\n  \"unit\": \"%s\",\n  \"cases\": [\n", unit);
+        emit(line);
+        bool first = true;
+        for (size_t i = 0; i < caseCount; i++) {
+            const benchCase& c = cases[i];
+            if (strncmp(c.name, only, strlen(only)) != 0) {
+                continue;
+            }
+            result r = measure(c, now);
+            uint64_t milli = (uint64_t) r.ticks * 1000 / r.iterations;
+            snprintf(line, sizeof(line),
+                "%s    {\"name\": \"%s\", \"size\": %lu, \"iterations\": %lu, \"per_op_milli\": %lu, \"checksum\": %lu}",
+                first ? "" : ",\n", c.name, (unsigned long) c.size, (unsigned long) r.iterations,
+                (unsigned long) milli, (unsigned long) r.checksum);
+            emit(line);
+            first = false;
+        }
+        emit("\n  ]\n}\n");
+    }
+}
+
+#endif
@@ -0,0 +1,371 @@
+// Checks the Gfx drawing kernels against the Adafruit_GFX calls they
+// replace and times both. Every case draws the same pseudo-random list of
+// primitives through each path into its own canvas, then compares the two
+// buffers pixel for pixel. Cached text is checked the same way against
+// Adafruit_GFX::print, measured text against getTextBounds, and drawing
+// into an indexed canvas against the RGB565 kernels. The
+// gradient engine is checked against a
+// floating point reference and timed in each of its modes. Exits non-zero
+// if any case differs.
+
+// The generated sketch is compiled into this file so the benchmarks can
+// reach its internal drawing code directly.
+#include "../jun/main.cpp"
+#include <chrono>
+#include <vector>
+
+using namespace arcada_gfx;
+
+static const int16_t W = 240;
+static const int16_t H = 240;
+
+struct op {
+    int16_t x;
+    int16_t y;
+    int16_t a;
+    int16_t b;
+    uint16_t c;
+};
+
+typedef void (*drawFn)(GFXcanvas16 *canvas, const op& o);
+
+static void gfxHLine(GFXcanvas16 *canvas, const op& o) { canvas->drawFastHLine(o.x, o.y, o.a, o.c); }
+static void kernHLine(GFXcanvas16 *canvas, const op& o) { kernelHLine(canvas, o.x, o.y, o.a, o.c); }
+static void gfxFillRect(GFXcanvas16 *canvas, const op& o) { canvas->fillRect(o.x, o.y, o.a, o.b, o.c); }
+static void kernFillRect(GFXcanvas16 *canvas, const op& o) { kernelFillRect(canvas, o.x, o.y, o.a, o.b, o.c); }
+static void gfxFillScreen(GFXcanvas16 *canvas, const op& o) { canvas->fillScreen(o.c); }
+static void kernFillScreen(GFXcanvas16 *canvas, const op& o) { kernelFillRect(canvas, 0, 0, W, H, o.c); }
+static void gfxPixel(GFXcanvas16 *canvas, const op& o) { canvas->drawPixel(o.x, o.y, o.c); }
+static void kernPixel(GFXcanvas16 *canvas, const op& o) { kernelPixel(canvas, o.x, o.y, o.c); }
+static void gfxFillCircle(GFXcanvas16 *canvas, const op& o) { canvas->fillCircle(o.x, o.y, o.a, o.c); }
+static void kernFillCircle(GFXcanvas16 *canvas, const op& o) { kernelFillCircle(canvas, o.x, o.y, o.a, o.c); }
+static void gfxDrawCircle(GFXcanvas16 *canvas, const op& o) { canvas->drawCircle(o.x, o.y, o.a, o.c); }
+static void kernDrawCircle(GFXcanvas16 *canvas, const op& o) { kernelDrawCircle(canvas, o.x, o.y, o.a, o.c); }
+
+static double runUs(GFXcanvas16 *canvas, drawFn f, const std::vector<op>& ops, int reps) {
+    auto start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < reps; rep++) {
+        for (const op& o : ops) {
+            f(canvas, o);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+static bool runCase(const char *name, drawFn gfx, drawFn kern, const std::vector<op>& ops, int reps) {
+    GFXcanvas16 expected(W, H);
+    GFXcanvas16 actual(W, H);
+
+    // Correctness first, from identical starting canvases
+    for (const op& o : ops) {
+        gfx(&expected, o);
+        kern(&actual, o);
+    }
+    int32_t mismatches = 0;
+    for (int32_t i = 0; i < (int32_t) W * H; i++) {
+        if (expected.getBuffer()[i] != actual.getBuffer()[i]) {
+            mismatches++;
+        }
+    }
+
+    double gfxUs = runUs(&expected, gfx, ops, reps);
+    double kernUs = runUs(&actual, kern, ops, reps);
+    double count = (double) ops.size() * reps;
+    printf("%-12s %8u %12.3f %12.3f %8.2fx  %s\n",
+        name, (unsigned) ops.size(), gfxUs * 1000.0 / count, kernUs * 1000.0 / count,
+        gfxUs / kernUs, mismatches == 0 ? "exact" : "MISMATCH");
+    if (mismatches != 0) {
+        printf("  %d pixels differ\n", (int) mismatches);
+    }
+    return mismatches == 0;
+}
+
+// Prints the same strings through Adafruit_GFX and through the glyph
+// cache, which draws into the Arcada canvas
+static bool checkText() {
+    // The watch face's mix: the time in the large font, the rest small
+    static const char *strings[] = { "12:34", "9:07", "AM", "PM", "Wed, Jan 5", "Sat, Dec 31" };
+    static const GFXfont *fonts[] = { &FreeSans24pt7b, &FreeSans24pt7b, &FreeSans9pt7b, &FreeSans9pt7b, &FreeSans9pt7b, &FreeSans9pt7b };
+    GFXcanvas16 expected(W, H);
+    arcada.createFrameBuffer(W, H);
+    GFXcanvas16 *actual = arcada.getCanvas();
+    std::vector<op> ops;
+    for (int i = 0; i < 400; i++) {
+        ops.push_back({ (int16_t) random(-40, W), (int16_t) random(0, H + 40), (int16_t) random(6), 0, (uint16_t) random(0x10000) });
+    }
+    double us[2];
+    for (int pass = 0; pass < 2; pass++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < 20; rep++) {
+            for (const op& o : ops) {
+                if (pass == 0) {
+                    expected.setFont(fonts[o.a]);
+                    expected.setTextColor(o.c);
+                    expected.setCursor(o.x, o.y);
+                    expected.print(strings[o.a]);
+                } else {
+                    textSetFont(fonts[o.a]);
+                    textSetColor(o.c);
+                    canvasLayout()->setCursor(o.x, o.y);
+                    printCached(strings[o.a]);
+                }
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        us[pass] = std::chrono::duration<double, std::micro>(end - start).count();
+    }
+    int32_t mismatches = 0;
+    for (int32_t i = 0; i < (int32_t) W * H; i++) {
+        if (expected.getBuffer()[i] != actual->getBuffer()[i]) {
+            mismatches++;
+        }
+    }
+    double count = ops.size() * 20.0;
+    printf("%-12s %8u %12.3f %12.3f %8.2fx  %s\n",
+        "text", (unsigned) ops.size(), us[0] * 1000.0 / count, us[1] * 1000.0 / count,
+        us[0] / us[1], mismatches == 0 ? "exact" : "MISMATCH");
+    printf("  glyph cache: %u hits, %u misses, %u evictions\n",
+        (unsigned) glyphCache.hits, (unsigned) glyphCache.misses, (unsigned) glyphCache.evictions);
+    return mismatches == 0;
+}
+
+// Measures random strings at random positions through textBoundsAt and
+// getTextBounds, including ones long enough for getTextBounds to wrap,
+// and through Gfx::measure and getTextBounds without wrapping
+static bool checkMeasure() {
+    static const GFXfont *fonts[] = { &FreeSans24pt7b, &FreeSans9pt7b };
+    GFXcanvas16 *canvas = arcada.getCanvas();
+    std::vector<std::vector<char> > strings;
+    for (int i = 0; i < 500; i++) {
+        std::vector<char> str;
+        int n = random(0, 14);
+        for (int k = 0; k < n; k++) {
+            str.push_back(random(10) == 0 ? '\n' : (char) random(0x20, 0x7F));
+        }
+        str.push_back('\0');
+        strings.push_back(str);
+    }
+    int32_t mismatches = 0;
+    // Keeps the timed getTextBounds calls from being optimised out
+    volatile uint32_t sink = 0;
+    double us[2] = { 0, 0 };
+    for (int f = 0; f < 2; f++) {
+        textSetFont(fonts[f]);
+        canvas->setFont(fonts[f]);
+        for (int pass = 0; pass < 2; pass++) {
+            auto start = std::chrono::steady_clock::now();
+            for (const std::vector<char>& str : strings) {
+                int16_t x1, y1;
+                uint16_t w, h;
+                int16_t x = (int16_t) (str.size() * 7 % 200) - 20;
+                if (pass == 0) {
+                    canvas->getTextBounds(&str[0], x, 0, &x1, &y1, &w, &h);
+                    sink += w;
+                } else {
+                    textBoundsAt(&str[0], x, 0, &x1, &y1, &w, &h);
+                    int16_t ex1, ey1;
+                    uint16_t ew, eh;
+                    canvas->getTextBounds(&str[0], x, 0, &ex1, &ey1, &ew, &eh);
+                    if (x1 != ex1 || y1 != ey1 || w != ew || h != eh) {
+                        mismatches++;
+                    }
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+            us[pass] += std::chrono::duration<double, std::micro>(end - start).count();
+        }
+    }
+    // The second pass also called getTextBounds to check each result
+    us[1] -= us[0];
+
+    Gfx::font measured[] = { Gfx::freeSans24(), Gfx::freeSans9() };
+    canvas->setTextWrap(false);
+    for (int f = 0; f < 2; f++) {
+        canvas->setFont(fonts[f]);
+        for (const std::vector<char>& str : strings) {
+            Prelude::charlist<14> cl;
+            memset(&cl.data.data[0], 0, sizeof(cl.data.data));
+            memcpy(&cl.data.data[0], &str[0], str.size());
+            cl.length = str.size();
+            int16_t x = (int16_t) (str.size() * 7 % 200) - 20;
+            juniper::tuple4<int16_t, int16_t, uint16_t, uint16_t> b = Gfx::measure<14>(measured[f], x, 0, cl);
+            int16_t ex1, ey1;
+            uint16_t ew, eh;
+            canvas->getTextBounds(&str[0], x, 0, &ex1, &ey1, &ew, &eh);
+            if (b.e1 != ex1 || b.e2 != ey1 || b.e3 != ew || b.e4 != eh) {
+                mismatches++;
+            }
+        }
+    }
+    canvas->setTextWrap(text.wrap);
+    canvas->setFont(text.font);
+    double count = strings.size() * 2.0;
+    printf("%-12s %8u %12.3f %12.3f %8.2fx  %s\n",
+        "measure", (unsigned) strings.size(), us[0] * 1000.0 / count, us[1] * 1000.0 / count,
+        us[0] / us[1], mismatches == 0 ? "exact" : "MISMATCH");
+    return mismatches == 0;
+}
+
+static gradient benchGradient(uint32_t count, bool dither) {
+    static const struct { uint8_t r, g, b; } colors[] = {
+        { 0xFC, 0x5C, 0x7D }, { 0x6A, 0x82, 0xFB }, { 0x10, 0xE0, 0x40 }, { 0xFF, 0xFF, 0xFF }
+    };
+    gradient gr;
+    gradientEvenStops(gr, colors, count, dither);
+    return gr;
+}
+
+// The two-stop vertical gradient the float code used to draw, with the
+// blue channel taken from the right colour and rounded rather than
+// truncated into RGB565. The engine must stay within one LSB of it.
+static bool checkGradient() {
+    GFXcanvas16 expected(W, H);
+    GFXcanvas16 actual(W, H);
+    gradient gr = benchGradient(2, false);
+    const gradientStop& a = gr.stops[0];
+    const gradientStop& b = gr.stops[1];
+    for (int16_t y = 0; y < H; y++) {
+        float t = (float) y / (H - 1);
+        uint16_t r = (uint16_t) ((a.r + (b.r - a.r) * t) * 31.0f / 255.0f + 0.5f);
+        uint16_t g = (uint16_t) ((a.g + (b.g - a.g) * t) * 63.0f / 255.0f + 0.5f);
+        uint16_t bl = (uint16_t) ((a.b + (b.b - a.b) * t) * 31.0f / 255.0f + 0.5f);
+        expected.drawFastHLine(0, y, W, (r << 11) | (g << 5) | bl);
+    }
+    gradientDrawLinear(&actual, gr, gradientAlongY, 0, 0, W, H);
+    int32_t worst = 0;
+    for (int32_t i = 0; i < (int32_t) W * H; i++) {
+        uint16_t e = expected.getBuffer()[i];
+        uint16_t c = actual.getBuffer()[i];
+        worst = std::max(worst, (int32_t) abs((e >> 11) - (c >> 11)));
+        worst = std::max(worst, (int32_t) abs(((e >> 5) & 0x3F) - ((c >> 5) & 0x3F)));
+        worst = std::max(worst, (int32_t) abs((e & 0x1F) - (c & 0x1F)));
+    }
+    printf("gradient vs float reference: max error %d LSB  %s\n", (int) worst, worst <= 1 ? "ok" : "MISMATCH");
+    return worst <= 1;
+}
+
+// Draws rectangles, spans and circles into an indexed canvas with colours
+// that all fit its palette, and checks the expanded result against the
+// RGB565 kernels. Then times expanding a whole screen, the work the blit
+// adds per pixel.
+static bool checkIndexed(uint8_t bits, const std::vector<op>& ops) {
+    GFXcanvas16 expected(W, H);
+    paletteCanvas actual(W, H, bits);
+    // With black, fifteen colours fill a 4-bit palette
+    uint16_t colors[15];
+    for (int i = 0; i < 15; i++) {
+        colors[i] = (uint16_t) random(1, 0x10000);
+    }
+    for (size_t i = 0; i < ops.size(); i++) {
+        const op& o = ops[i];
+        uint16_t c = colors[i % 15];
+        uint16_t index = canvasColor(&actual, c);
+        switch (i % 4) {
+            case 0:
+                kernelFillRect(&expected, o.x, o.y, o.a, o.b, c);
+                kernelFillRect(&actual, o.x, o.y, o.a, o.b, index);
+                break;
+            case 1:
+                kernelHLine(&expected, o.x, o.y, o.a, c);
+                kernelHLine(&actual, o.x, o.y, o.a, index);
+                break;
+            case 2:
+                kernelFillCircle(&expected, o.x, o.y, o.a & 63, c);
+                kernelFillCircle(&actual, o.x, o.y, o.a & 63, index);
+                break;
+            case 3:
+                kernelDrawCircle(&expected, o.x, o.y, o.a & 63, c);
+                kernelDrawCircle(&actual, o.x, o.y, o.a & 63, index);
+                break;
+        }
+    }
+    std::vector<uint16_t> row(W);
+    int32_t mismatches = 0;
+    for (int16_t y = 0; y < H; y++) {
+        actual.expand(0, y, W, &row[0]);
+        for (int16_t x = 0; x < W; x++) {
+            if (row[x] != expected.getBuffer()[(int32_t) y * W + x]) {
+                mismatches++;
+            }
+        }
+    }
+    const int reps = 200;
+    auto start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < reps; rep++) {
+        for (int16_t y = 0; y < H; y++) {
+            actual.expand(rep & 1, y, W - 1, &row[0]);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    printf("indexed %d-bit: %u colours, %u bytes, expand %.1f us/screen  %s\n",
+        (int) bits, (unsigned) actual.paletteSize(), (unsigned) ((int32_t) W * H * bits / 8),
+        std::chrono::duration<double, std::micro>(end - start).count() / reps,
+        mismatches == 0 ? "exact" : "MISMATCH");
+    if (mismatches != 0) {
+        printf("  %d pixels differ\n", (int) mismatches);
+    }
+    return mismatches == 0;
+}
+
+static void timeGradient(const char *name, const gradient& gr, int axis, int reps) {
+    GFXcanvas16 canvas(W, H);
+    auto start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < reps; rep++) {
+        if (axis < 0) {
+            gradientDrawRadial(&canvas, gr, 0, 0, W, H, W / 2, H / 2, W / 2);
+        } else {
+            gradientDrawLinear(&canvas, gr, (gradientAxis) axis, 0, 0, W, H);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    printf("%-20s %12.3f\n", name, std::chrono::duration<double, std::micro>(end - start).count() / reps);
+}
+
+int main() {
+    randomSeed(12345);
+    std::vector<op> spans, rects, screens, pixels, circles;
+
+    for (int i = 0; i < 2000; i++) {
+        uint16_t c = (uint16_t) random(0x10000);
+        // Ranges reach past every edge so clipping is exercised too
+        spans.push_back({ (int16_t) random(-60, W + 20), (int16_t) random(-10, H + 10), (int16_t) random(-5, W + 40), 1, c });
+        rects.push_back({ (int16_t) random(-60, W + 20), (int16_t) random(-60, H + 20), (int16_t) random(-5, 120), (int16_t) random(-5, 120), c });
+        pixels.push_back({ (int16_t) random(-10, W + 10), (int16_t) random(-10, H + 10), 0, 0, c });
+    }
+    for (int i = 0; i < 20; i++) {
+        screens.push_back({ 0, 0, 0, 0, (uint16_t) random(0x10000) });
+    }
+    // Every radius up to past the screen size, centred and at random positions
+    for (int16_t r = 0; r <= 130; r++) {
+        circles.push_back({ W / 2, H / 2, r, 0, (uint16_t) random(0x10000) });
+        circles.push_back({ (int16_t) random(-40, W + 40), (int16_t) random(-40, H + 40), r, 0, (uint16_t) random(0x10000) });
+    }
+
+    printf("%-12s %8s %12s %12s %9s\n", "case", "ops", "gfx ns/op", "kernel ns/op", "speedup");
+    bool ok = true;
+    ok &= runCase("hline", gfxHLine, kernHLine, spans, 20);
+    ok &= runCase("fillRect", gfxFillRect, kernFillRect, rects, 5);
+    ok &= runCase("fillScreen", gfxFillScreen, kernFillScreen, screens, 20);
+    ok &= runCase("pixel", gfxPixel, kernPixel, pixels, 200);
+    ok &= runCase("fillCircle", gfxFillCircle, kernFillCircle, circles, 20);
+    ok &= runCase("drawCircle", gfxDrawCircle, kernDrawCircle, circles, 20);
+    ok &= checkText();
+    ok &= checkMeasure();
+    ok &= checkIndexed(8, rects);
+    ok &= checkIndexed(4, rects);
+
+    printf("\n");
+    ok &= checkGradient();
+    printf("%-20s %12s\n", "gradient (3 stops)", "us/screen");
+    const char *names[] = { "vertical", "horizontal", "diagonal" };
+    for (int axis = 0; axis < 3; axis++) {
+        char name[32];
+        timeGradient(names[axis], benchGradient(3, false), axis, 200);
+        snprintf(name, sizeof(name), "%s dithered", names[axis]);
+        timeGradient(name, benchGradient(3, true), axis, 200);
+    }
+    timeGradient("radial", benchGradient(3, false), -1, 200);
+    timeGradient("radial dithered", benchGradient(3, true), -1, 200);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,878 @@
+// Checks and times pieces of the Juniper runtime at the top of the
+// generated sketch. Cell allocation is timed from malloc, as it is
+// without JUN_CELL_POOLS, from the fixed-block pools that replace
+// operator new, and from the pools behind a frame arena. Each case also
+// checks that every cell was destroyed exactly once and that the pools
+// are empty again at the end. Copying a refcell and a
+// juniper::atomic_refcell is timed, and atomic_refcell is checked against
+// two threads sharing one cell. List::map and List::fold are timed with a
+// closure, a plain function, and elements and state that are costly to
+// copy.
+// Copying and assigning ADTs is timed for alternatives that are trivially
+// copyable and for ones that are not. A Signal pipeline (map, filter,
+// foldP, latch) is timed over plain and reference values, and the sizes of
+// the maybe and sig types are listed. The List operations that build a new
+// list are timed on an eight-element list at capacities of 16, 256 and
+// 4096, and a hash of each result, tail included, is printed so that
+// rewrites can be checked against it; "pass" is a list passed by value
+// and read, and "pass cow" the same with a juniper::cow_list, which is
+// what cow_list is for. juniper::hash is checked to agree with == on
+// records, floats, ADTs, maybes and lists, and comparing and hashing a
+// record that holds a list is timed, as are Signal::dropRepeats and
+// List::member over records. Values are round-tripped through
+// juniper::binary, including a list, maybes, the packed BLE record and
+// Ble::readGeneric, which must read a short value as zeros, and encoding
+// and decoding are timed. juniper::stack is checked to find the depth of
+// a known amount of stack use and to charge it to the right scope. The
+// allocation tracker is checked to count cells, rcptrs and cow_array
+// blocks by size and per frame, and to see every block the cases made
+// freed by the end. Exits non-zero if any check fails.
+
+// Pools and an arena small enough that the overflow paths get exercised
+#define JUN_CELL_POOLS
+#define JUN_POOL_BLOCKS 256
+#define JUN_FRAME_ARENA_BYTES 4096
+#define JUN_STACK_WATCH
+#define JUN_ALLOC_TRACK
+
+// The generated sketch is compiled into this file so the benchmarks can
+// reach the runtime directly.
+#include "../jun/main.cpp"
+#include <alloca.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Counts its live copies, so a leak or a double destroy shows up
+struct tracked {
+    static int32_t live;
+    uint32_t value[3];
+
+    tracked(uint32_t v) : value{ v, v, v } {
+        live++;
+    }
+
+    tracked(const tracked& rhs) : value{ rhs.value[0], rhs.value[1], rhs.value[2] } {
+        live++;
+    }
+
+    ~tracked() {
+        live--;
+    }
+};
+
+int32_t tracked::live = 0;
+
+static uint32_t finalized = 0;
+
+static juniper::unit countFinalize(void *ptr) {
+    finalized++;
+    return {};
+}
+
+typedef juniper::counted_cell<juniper::basic_container<tracked>> heapCell;
+
+// Makes count cells from malloc the way new did before the pools
+// replaced it, keeping at most window of them alive at once, and frees
+// the oldest first
+static double runHeapCells(uint32_t count, uint32_t window, uint32_t& checksum) {
+    std::vector<heapCell *> live(window, nullptr);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        heapCell *&slot = live[i % window];
+        if (slot != nullptr) {
+            slot->~heapCell();
+            free(slot);
+        }
+        slot = new (malloc(sizeof(heapCell))) heapCell(juniper::basic_container<tracked>(tracked(i)));
+        checksum += slot->data.get()->value[1];
+    }
+    for (heapCell *slot : live) {
+        if (slot != nullptr) {
+            slot->~heapCell();
+            free(slot);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+// The same with refcells, whose cells come from the pools. With frames
+// set the cells of each window are made inside a frame, as loop() would.
+static double runCells(uint32_t count, uint32_t window, bool frames, uint32_t& checksum) {
+    typedef juniper::refcell<tracked> cell;
+    std::vector<cell> live(window);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        if (frames && i % window == 0) {
+            juniper::memory::frame_begin();
+        }
+        live[i % window] = cell(tracked(i));
+        checksum += live[i % window].get()->value[1];
+        if (frames && i % window == window - 1) {
+            // Drop the frame's cells before it ends so the arena can reset
+            for (cell& c : live) {
+                c = cell();
+            }
+            juniper::memory::frame_end();
+        }
+    }
+    live.clear();
+    if (frames && count % window != 0) {
+        juniper::memory::frame_end();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+static bool poolsEmpty() {
+    bool empty = juniper::memory::arena.live == 0;
+    for (uint8_t i = 0; i < juniper::memory::pool_count; i++) {
+        empty = empty && juniper::memory::pools[i].live == 0;
+    }
+    return empty;
+}
+
+static bool runCase(const char *name, uint32_t window) {
+    const uint32_t count = 200000;
+    uint32_t checksums[3] = { 0, 0, 0 };
+    double ns[3];
+    ns[0] = runHeapCells(count, window, checksums[0]);
+    ns[1] = runCells(count, window, false, checksums[1]);
+    ns[2] = runCells(count, window, true, checksums[2]);
+    bool ok = tracked::live == 0 && poolsEmpty() && checksums[0] == checksums[1] && checksums[1] == checksums[2];
+    printf("%-12s %8u %10.1f %10.1f %10.1f  %s\n", name, (unsigned) window, ns[0], ns[1], ns[2], ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// An rcptr's finalizer runs once, when the last copy goes
+static bool checkFinalizer() {
+    finalized = 0;
+    {
+        auto p = juniper::make_rcptr(&finalized, juniper::function<void, juniper::unit(void *)>(countFinalize));
+        auto q = p;
+        p = q;
+    }
+    bool ok = finalized == 1 && poolsEmpty();
+    printf("rcptr finalizer runs once: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Copies a reference into a ring of slots, so that every copy increments
+// the count and drops the reference the slot held before
+template<typename Cell>
+static void copyCell(const Cell& c, uint32_t count) {
+    Cell ring[8];
+    for (uint32_t i = 0; i < count; i++) {
+        ring[i & 7] = c;
+    }
+}
+
+template<typename Cell>
+static double timeCopies(uint32_t count) {
+    Cell c(tracked(1));
+    auto start = std::chrono::steady_clock::now();
+    copyCell(c, count);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+static bool runCounts() {
+    const uint32_t count = 10000000;
+    double plain = timeCopies<juniper::refcell<tracked>>(count);
+    double atomic = timeCopies<juniper::atomic_refcell<tracked>>(count);
+
+    // Two threads copying one cell at once stand in for loop() and a
+    // callback; the cell has to be destroyed exactly once, at the end
+    {
+        juniper::atomic_refcell<tracked> shared(tracked(2));
+        std::thread other(copyCell<juniper::atomic_refcell<tracked>>, std::cref(shared), count);
+        copyCell(shared, count);
+        other.join();
+    }
+    bool ok = tracked::live == 0;
+    printf("\n%-12s %10s %10s\n", "count", "plain ns", "atomic ns");
+    printf("%-12s %10.2f %10.2f  %s\n", "copy", plain, atomic, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+template<typename T, int n>
+using list = juniper::records::recordt_0<juniper::array<T, n>, uint32_t>;
+
+const int combinatorLength = 256;
+
+// The shapes the compiler emits: a closure struct with a function taking
+// it by reference, and a bare function
+struct offsetClosure {
+    int32_t offset;
+
+    offsetClosure(int32_t init_offset) :
+        offset(init_offset) {}
+};
+
+static int32_t addOne(int32_t x) {
+    return x + 1;
+}
+
+// Times calls repetitions of body, which returns a value folded into
+// checksum, and reports ns per list element for the fastest of five runs
+template<typename Body>
+static double timeCombinator(uint32_t calls, uint32_t& checksum, Body body) {
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < calls; i++) {
+            checksum += body(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / ((double) calls * combinatorLength);
+        best = run == 0 || ns < best ? ns : best;
+    }
+    return best;
+}
+
+static bool runCombinators() {
+    const uint32_t calls = 20000;
+    list<int32_t, combinatorLength> ints;
+    list<juniper::refcell<int32_t>, combinatorLength> cells;
+    ints.length = combinatorLength;
+    cells.length = combinatorLength;
+    for (int i = 0; i < combinatorLength; i++) {
+        ints.data[i] = i;
+        cells.data[i] = juniper::refcell<int32_t>(i);
+    }
+
+    uint32_t checksum = 0;
+    printf("\n%-12s %10s\n", "combinator", "ns/elem");
+    double ns = timeCombinator(calls, checksum, [&](uint32_t i) {
+        auto f = juniper::function<offsetClosure, int32_t(int32_t)>(offsetClosure((int32_t) i), [](offsetClosure& junclosure, int32_t x) -> int32_t {
+            return x + junclosure.offset;
+        });
+        return List::map<int32_t, offsetClosure, int32_t, combinatorLength>(f, ints).data[i % combinatorLength];
+    });
+    printf("%-12s %10.3f\n", "map closure", ns);
+    ns = timeCombinator(calls, checksum, [&](uint32_t i) {
+        return List::map<int32_t, void, int32_t, combinatorLength>(juniper::function<void, int32_t(int32_t)>(addOne), ints).data[i % combinatorLength];
+    });
+    printf("%-12s %10.3f\n", "map function", ns);
+    ns = timeCombinator(calls, checksum, [&](uint32_t i) {
+        return List::map<int32_t, void, juniper::refcell<int32_t>, combinatorLength>(juniper::function<void, int32_t(juniper::refcell<int32_t>)>([](juniper::refcell<int32_t> c) -> int32_t {
+            return *c.get();
+        }), cells).data[i % combinatorLength];
+    });
+    printf("%-12s %10.3f\n", "map refcell", ns);
+    ns = timeCombinator(calls, checksum, [&](uint32_t i) {
+        auto f = juniper::function<offsetClosure, int32_t(int32_t, int32_t)>(offsetClosure((int32_t) i), [](offsetClosure& junclosure, int32_t x, int32_t s) -> int32_t {
+            return s + x * junclosure.offset;
+        });
+        return List::fold<int32_t, offsetClosure, int32_t, combinatorLength>(f, 0, ints);
+    });
+    printf("%-12s %10.3f\n", "fold closure", ns);
+    // A state as large as a small list, copied in and out of every step
+    typedef juniper::array<int32_t, 16> histogram;
+    ns = timeCombinator(calls, checksum, [&](uint32_t i) {
+        histogram zero;
+        zero.fill(0);
+        return List::fold<histogram, void, int32_t, combinatorLength>(juniper::function<void, histogram(int32_t, histogram)>([](int32_t x, histogram s) -> histogram {
+            s[x & 15] += x;
+            return s;
+        }), zero, ints)[i & 15];
+    });
+    printf("%-12s %10.3f\n", "fold array", ns);
+    printf("checksum %lu\n", (unsigned long) checksum);
+    return true;
+}
+
+const int adtLength = 256;
+
+// Copies src into a fresh array, then assigns it over dst, the two things
+// the signal pipeline does to ADT values; returns ns per value for the
+// fastest of five runs
+template<typename T>
+static double timeAdt(T (&src)[adtLength], T (&dst)[adtLength], uint32_t repetitions) {
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t r = 0; r < repetitions; r++) {
+            for (int i = 0; i < adtLength; i++) {
+                T copy(src[i]);
+                dst[(i + r) % adtLength] = copy;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / ((double) repetitions * adtLength);
+        best = run == 0 || ns < best ? ns : best;
+    }
+    return best;
+}
+
+// After timeAdt every slot of src has been copied into dst, shifted along
+// by one less than the number of repetitions
+template<typename T>
+static bool sameAdt(T (&src)[adtLength], T (&dst)[adtLength], uint32_t repetitions) {
+    bool same = true;
+    for (int i = 0; i < adtLength; i++) {
+        same = same && src[i].data == dst[(i + repetitions - 1) % adtLength].data;
+    }
+    return same;
+}
+
+static bool runAdts() {
+    const uint32_t repetitions = 2000;
+    static CWatch::month months[adtLength], monthsOut[adtLength];
+    static Prelude::maybe<uint8_t> bytes[adtLength], bytesOut[adtLength];
+    static Prelude::sig<int32_t> sigs[adtLength], sigsOut[adtLength];
+    static Prelude::maybe<juniper::refcell<tracked>> cells[adtLength], cellsOut[adtLength];
+    CWatch::month (*makeMonth[])() = { CWatch::january, CWatch::june, CWatch::december };
+    for (int i = 0; i < adtLength; i++) {
+        months[i] = makeMonth[i % 3]();
+        bytes[i] = i % 2 ? Prelude::just<uint8_t>((uint8_t) i) : Prelude::nothing<uint8_t>();
+        sigs[i] = Prelude::signal<int32_t>(i % 2 ? Prelude::just<int32_t>(i) : Prelude::nothing<int32_t>());
+        cells[i] = i % 2 ? Prelude::just<juniper::refcell<tracked>>(juniper::refcell<tracked>(tracked(i))) : Prelude::nothing<juniper::refcell<tracked>>();
+    }
+
+    printf("\n%-12s %10s\n", "adt", "ns/value");
+    bool ok = true;
+    double ns = timeAdt(months, monthsOut, repetitions);
+    ok &= sameAdt(months, monthsOut, repetitions);
+    printf("%-12s %10.3f\n", "month", ns);
+    ns = timeAdt(bytes, bytesOut, repetitions);
+    ok &= sameAdt(bytes, bytesOut, repetitions);
+    printf("%-12s %10.3f\n", "maybe u8", ns);
+    ns = timeAdt(sigs, sigsOut, repetitions);
+    ok &= sameAdt(sigs, sigsOut, repetitions);
+    printf("%-12s %10.3f\n", "sig i32", ns);
+    ns = timeAdt(cells, cellsOut, repetitions);
+    ok &= sameAdt(cells, cellsOut, repetitions);
+    for (int i = 0; i < adtLength; i++) {
+        cells[i] = Prelude::nothing<juniper::refcell<tracked>>();
+    }
+    // Only cellsOut holds the cells now, and it holds each of them once
+    ok &= tracked::live == adtLength / 2;
+    for (int i = 0; i < adtLength; i++) {
+        cellsOut[i] = Prelude::nothing<juniper::refcell<tracked>>();
+    }
+    ok &= tracked::live == 0;
+    printf("%-12s %10.3f  %s\n", "maybe cell", ns, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// One frame of a signal pipeline: an event on every other frame, mapped,
+// filtered, folded into a running state and latched
+template<typename T>
+struct pipeline {
+    T state;
+    T latched;
+
+    pipeline(T init) : state(init), latched(init) {}
+
+    T frame(uint32_t i, T value) {
+        Prelude::sig<T> s = Prelude::signal<T>(i % 2 ? Prelude::just<T>(value) : Prelude::nothing<T>());
+        Prelude::sig<T> m = Signal::map<T, void, T>(juniper::function<void, T(T)>([](T x) -> T {
+            return x;
+        }), s);
+        Prelude::sig<T> f = Signal::filter<void, T>(juniper::function<void, bool(T)>([](T x) -> bool {
+            return false;
+        }), m);
+        Prelude::sig<T> folded = Signal::foldP<T, void, T>(juniper::function<void, T(T, T)>([](T x, T s) -> T {
+            return x;
+        }), state, f);
+        Signal::latch<T>(latched, folded);
+        return latched;
+    }
+};
+
+template<typename T, typename Make, typename Read>
+static double timePipeline(uint32_t frames, uint32_t& checksum, Make make, Read read) {
+    pipeline<T> p(make(0));
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < frames; i++) {
+            checksum += read(p.frame(i, make(i)));
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+        best = run == 0 || ns < best ? ns : best;
+    }
+    return best;
+}
+
+static bool runSignals() {
+    const uint32_t frames = 200000;
+    uint32_t checksum = 0;
+    printf("\n%-12s %10s\n", "pipeline", "ns/frame");
+    double ns = timePipeline<int32_t>(frames, checksum, [](uint32_t i) {
+        return (int32_t) i;
+    }, [](int32_t x) {
+        return (uint32_t) x;
+    });
+    printf("%-12s %10.3f\n", "int32", ns);
+    juniper::refcell<int32_t> cells[2] = { juniper::refcell<int32_t>(1), juniper::refcell<int32_t>(2) };
+    ns = timePipeline<juniper::refcell<int32_t>>(frames, checksum, [&](uint32_t i) {
+        return cells[i % 2];
+    }, [](juniper::refcell<int32_t> x) {
+        return (uint32_t) *x.get();
+    });
+    printf("%-12s %10.3f\n", "refcell", ns);
+    printf("checksum %lu\n", (unsigned long) checksum);
+
+    printf("\n%-28s %6s\n", "type", "bytes");
+    printf("%-28s %6u\n", "maybe<uint8_t>", (unsigned) sizeof(Prelude::maybe<uint8_t>));
+    printf("%-28s %6u\n", "maybe<int32_t>", (unsigned) sizeof(Prelude::maybe<int32_t>));
+    printf("%-28s %6u\n", "maybe<refcell<int32_t>>", (unsigned) sizeof(Prelude::maybe<juniper::refcell<int32_t>>));
+    printf("%-28s %6u\n", "maybe<CWatch::month>", (unsigned) sizeof(Prelude::maybe<CWatch::month>));
+    printf("%-28s %6u\n", "sig<uint8_t>", (unsigned) sizeof(Prelude::sig<uint8_t>));
+    printf("%-28s %6u\n", "sig<int32_t>", (unsigned) sizeof(Prelude::sig<int32_t>));
+    printf("%-28s %6u\n", "sig<refcell<int32_t>>", (unsigned) sizeof(Prelude::sig<juniper::refcell<int32_t>>));
+    printf("%-28s %6u\n", "sig<CWatch::month>", (unsigned) sizeof(Prelude::sig<CWatch::month>));
+    return true;
+}
+
+const uint32_t listLength = 8;
+
+// Hashes every slot of the list, including those past its length
+template<int n>
+static uint32_t hashList(const list<int32_t, n>& lst) {
+    uint32_t h = 2166136261u ^ lst.length;
+    for (int i = 0; i < n; i++) {
+        h = (h ^ (uint32_t) lst.data.data[i]) * 16777619u;
+    }
+    return h;
+}
+
+// ns per call of op, fastest of five runs; the list op returns is hashed
+// once and folded into hash
+template<int n, typename Op>
+static double timeListOp(uint32_t& hash, Op op) {
+    const uint32_t calls = 4000000 / n + 1000;
+    list<int32_t, n> lst = List::replicate<int32_t, n>(listLength, 0);
+    for (uint32_t i = 0; i < listLength; i++) {
+        lst.data[i] = (int32_t) i + 1;
+    }
+    hash = hash * 31 + hashList<n>(op(lst, 3));
+    uint32_t checksum = 0;
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < calls; i++) {
+            const list<int32_t, n>& out = op(lst, i);
+            checksum += out.data.data[(i * 7) % n];
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / calls;
+        best = run == 0 || ns < best ? ns : best;
+    }
+    hash += checksum != 0 ? 0 : 1;
+    return best;
+}
+
+// Takes its list by value, as most generated functions do, and reads it
+template<int n>
+static __attribute__((noinline)) list<int32_t, n> passAlong(list<int32_t, n> lst, uint32_t i) {
+    lst.length = List::get<uint32_t, int32_t, n>(i % listLength, lst) > 0 ? lst.length : 0;
+    return lst;
+}
+
+// The same with a cow_list, whose copies share one block
+template<int n>
+static __attribute__((noinline)) juniper::cow_list<int32_t, n> passAlongCow(juniper::cow_list<int32_t, n> lst, uint32_t i) {
+    lst.length = lst.data[i % listLength] > 0 ? lst.length : 0;
+    return lst;
+}
+
+// As timeListOp, for passAlongCow
+template<int n>
+static double timeCowPass(uint32_t& hash) {
+    const uint32_t calls = 4000000 / n + 1000;
+    list<int32_t, n> lst = List::replicate<int32_t, n>(listLength, 0);
+    for (uint32_t i = 0; i < listLength; i++) {
+        lst.data[i] = (int32_t) i + 1;
+    }
+    juniper::cow_list<int32_t, n> cow(lst);
+    hash = hash * 31 + hashList<n>(passAlongCow<n>(cow, 3));
+    uint32_t checksum = 0;
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < calls; i++) {
+            const juniper::cow_list<int32_t, n>& out = passAlongCow<n>(cow, i);
+            checksum += out.data[(i * 7) % n];
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / calls;
+        best = run == 0 || ns < best ? ns : best;
+    }
+    hash += checksum != 0 ? 0 : 1;
+    return best;
+}
+
+template<int n>
+static void runListOps(double (&ns)[9], uint32_t& hash) {
+    ns[0] = timeListOp<n>(hash, [](list<int32_t, n>& lst, uint32_t i) {
+        return List::map<int32_t, void, int32_t, n>(juniper::function<void, int32_t(int32_t)>(addOne), lst);
+    });
+    ns[1] = timeListOp<n>(hash, [](list<int32_t, n>& lst, uint32_t i) {
+        return List::concat<int32_t, n, n, n>(lst, lst);
+    });
+    ns[2] = timeListOp<n>(hash, [](list<int32_t, n>& lst, uint32_t i) {
+        return List::resize<int32_t, n, n>(lst);
+    });
+    ns[3] = timeListOp<n>(hash, [](list<int32_t, n>& lst, uint32_t i) {
+        return List::appendPure<int32_t, n>((int32_t) i, lst);
+    });
+    ns[4] = timeListOp<n>(hash, [](list<int32_t, n>& lst, uint32_t i) {
+        return List::setPure<int32_t, n>(i % listLength, (int32_t) i, lst);
+    });
+    ns[5] = timeListOp<n>(hash, [](list<int32_t, n>& lst, uint32_t i) {
+        return List::removePure<int32_t, n>((int32_t) (i % listLength + 1), lst);
+    });
+    ns[6] = timeListOp<n>(hash, [](list<int32_t, n>& lst, uint32_t i) {
+        return List::replicate<int32_t, n>(listLength, (int32_t) i);
+    });
+    ns[7] = timeListOp<n>(hash, [](list<int32_t, n>& lst, uint32_t i) {
+        return passAlong<n>(lst, i);
+    });
+    ns[8] = timeCowPass<n>(hash);
+}
+
+static bool runLists() {
+    static const char *names[9] = { "map", "concat", "resize", "appendPure", "setPure", "removePure", "replicate", "pass",
+        "pass cow" };
+    double ns[3][9];
+    uint32_t hash = 0;
+    runListOps<16>(ns[0], hash);
+    runListOps<256>(ns[1], hash);
+    runListOps<4096>(ns[2], hash);
+    printf("\n%-12s %10s %10s %10s\n", "list ns", "cap 16", "cap 256", "cap 4096");
+    for (int i = 0; i < 9; i++) {
+        printf("%-12s %10.1f %10.1f %10.1f\n", names[i], ns[0][i], ns[1][i], ns[2][i]);
+    }
+    printf("hash %08lx\n", (unsigned long) hash);
+    return true;
+}
+
+// A record holding a list, as a frame's state might
+typedef juniper::records::recordt_0<list<int32_t, 256>, uint32_t> history;
+
+// The records that are hashed and written field by field, as the sketch
+// would describe them from a .jun inline block
+namespace juniper
+{
+    namespace binary
+    {
+        template<>
+        struct fields<CWatch::datetime> {
+            typedef CWatch::datetime T;
+            typedef field_list<JUN_FIELD(T, day), JUN_FIELD(T, dayOfWeek), JUN_FIELD(T, hours),
+                JUN_FIELD(T, minutes), JUN_FIELD(T, month), JUN_FIELD(T, seconds), JUN_FIELD(T, year)> list;
+        };
+
+        template<>
+        struct fields<Color::hsv> {
+            typedef Color::hsv T;
+            typedef field_list<JUN_FIELD(T, h), JUN_FIELD(T, s), JUN_FIELD(T, v)> list;
+        };
+
+        template<>
+        struct fields<history> {
+            typedef history T;
+            typedef field_list<JUN_FIELD(T, data), JUN_FIELD(T, length)> list;
+        };
+    }
+}
+
+// ns per call of body, fastest of five runs
+template<typename Body>
+static double timeCalls(uint32_t calls, uint32_t& checksum, Body body) {
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < calls; i++) {
+            checksum += body(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / calls;
+        best = run == 0 || ns < best ? ns : best;
+    }
+    return best;
+}
+
+static bool runHashing() {
+    bool ok = true;
+    Color::rgb pinkAgain(CWatch::pink.b, CWatch::pink.g, CWatch::pink.r);
+    ok &= pinkAgain == CWatch::pink && juniper::hash(pinkAgain) == juniper::hash(CWatch::pink);
+    ok &= juniper::hash(Color::red) != juniper::hash(Color::green);
+    Color::hsv zero(0.0f, 0.5f, 1.0f);
+    Color::hsv negativeZero(-0.0f, 0.5f, 1.0f);
+    ok &= zero == negativeZero && juniper::hash(zero) == juniper::hash(negativeZero);
+    // month has twelve alternatives, the most of any ADT in the sketch
+    ok &= juniper::hash(CWatch::march()) == juniper::hash(CWatch::march());
+    ok &= juniper::hash(CWatch::march()) != juniper::hash(CWatch::april());
+    ok &= juniper::hash(Prelude::nothing<Io::pinState>()) == juniper::hash(Prelude::nothing<Io::pinState>());
+    ok &= juniper::hash(Prelude::just<Io::pinState>(Io::low())) != juniper::hash(Prelude::nothing<Io::pinState>());
+    CWatch::dayDateTimeBLE packed(1, 9, 2020, 18, 40, 0);
+    ok &= juniper::hash(packed) == juniper::hash(CWatch::dayDateTimeBLE(packed));
+
+    history a(List::replicate<int32_t, 256>(200, 7), 0);
+    history b = a;
+    ok &= a == b && juniper::hash(a) == juniper::hash(b);
+    b.data.data[199] = 8;
+    ok &= a != b;
+    b = a;
+
+    list<Color::rgb, 64> colors = List::replicate<Color::rgb, 64>(48, Color::black);
+    colors.data[47] = CWatch::pink;
+    ok &= List::member<Color::rgb, 64>(CWatch::pink, colors);
+    ok &= !List::member<Color::rgb, 64>(CWatch::purpleBlue, colors);
+
+    // Every other value repeats the one before
+    Prelude::maybe<Color::rgb> previous = Prelude::nothing<Color::rgb>();
+    uint32_t passed = 0;
+    for (uint32_t i = 0; i < 64; i++) {
+        Color::rgb c((uint8_t) (i / 2), 0, 0);
+        Prelude::sig<Color::rgb> out = Signal::dropRepeats<Color::rgb>(previous, Prelude::signal<Color::rgb>(Prelude::just<Color::rgb>(c)));
+        passed += out.signal().id() == 0 ? 1 : 0;
+    }
+    ok &= passed == 32;
+
+    uint32_t checksum = 0;
+    double equalNs = timeCalls(200000, checksum, [&](uint32_t i) {
+        b.length = i & 1;
+        return a == b ? 1 : 0;
+    });
+    double hashNs = timeCalls(200000, checksum, [&](uint32_t i) {
+        b.length = i;
+        return juniper::hash(b);
+    });
+    double memberNs = timeCalls(200000, checksum, [&](uint32_t i) {
+        return List::member<Color::rgb, 64>(i & 1 ? CWatch::pink : CWatch::purpleBlue, colors) ? 1 : 0;
+    });
+    double dropNs = timeCalls(200000, checksum, [&](uint32_t i) {
+        Color::rgb c((uint8_t) (i / 2), 0, 0);
+        return Signal::dropRepeats<Color::rgb>(previous, Prelude::signal<Color::rgb>(Prelude::just<Color::rgb>(c))).signal().id();
+    });
+    printf("\n%-24s %8s\n", "compare", "ns");
+    printf("%-24s %8.1f\n", "== history (256)", equalNs);
+    printf("%-24s %8.1f\n", "hash history (256)", hashNs);
+    printf("%-24s %8.1f\n", "member rgb (48 of 64)", memberNs);
+    printf("%-24s %8.1f\n", "dropRepeats rgb", dropNs);
+    if (!ok) {
+        printf("hash or equality check failed\n");
+    }
+    return ok && checksum != 0;
+}
+
+// Decodes into back, which must differ from value
+template<typename T>
+static bool roundTrips(const T& value, T back) {
+    uint8_t buf[juniper::binary::codec<T>::max_size];
+    size_t n = juniper::binary::encode(value, buf);
+    return n <= sizeof(buf) && juniper::binary::decode(buf, n, back) && back == value;
+}
+
+template<typename T>
+static bool roundTrips(const T& value) {
+    return roundTrips(value, T());
+}
+
+static bool runBinary() {
+    typedef CWatch::datetime clock;
+    bool ok = true;
+    ok &= roundTrips(CWatch::clockState);
+    ok &= roundTrips(Prelude::just<Io::pinState>(Io::high()));
+    ok &= roundTrips(Prelude::nothing<Io::pinState>());
+    ok &= roundTrips(Prelude::just<Color::rgb>(CWatch::pink));
+    ok &= roundTrips(Prelude::nothing<Color::rgb>());
+    ok &= roundTrips(Color::hsv(-0.0f, 0.5f, 1.0f));
+    ok &= roundTrips(juniper::tuple2<int32_t, Color::rgb>(-5, Color::red), juniper::tuple2<int32_t, Color::rgb>(0, Color::rgb()));
+
+    // A list writes only the elements in use
+    history a(List::replicate<int32_t, 256>(3, 7), 0);
+    ok &= roundTrips(a);
+    uint8_t listBuf[juniper::binary::codec<history>::max_size];
+    ok &= juniper::binary::encode(a, listBuf) == 4 + 4 * 3 + 4;
+    listBuf[0] = 1;
+    listBuf[1] = 1;
+    history tooLong;
+    ok &= !juniper::binary::decode(listBuf, sizeof(listBuf), tooLong);
+
+    // The packed BLE record encodes as it lies in memory
+    CWatch::dayDateTimeBLE packed(1, 9, 2020, 18, 40, 0);
+    uint8_t packedBuf[juniper::binary::codec<CWatch::dayDateTimeBLE>::max_size];
+    ok &= sizeof(packedBuf) == sizeof(packed);
+    ok &= juniper::binary::encode(packed, packedBuf) == sizeof(packed) && memcmp(packedBuf, &packed, sizeof(packed)) == 0;
+    CWatch::dayDateTimeBLE unpacked;
+    ok &= !juniper::binary::decode(packedBuf, sizeof(packed) - 1, unpacked);
+
+    uint8_t clockBuf[juniper::binary::tagged_size<clock>::value];
+    size_t clockN = juniper::binary::encode_tagged(CWatch::clockState, 2, clockBuf);
+    clock c;
+    ok &= juniper::binary::decode_tagged(clockBuf, clockN, 2, c) && c == CWatch::clockState;
+    ok &= !juniper::binary::decode_tagged(clockBuf, clockN, 3, c);
+    clockBuf[2 + 1] = 200;
+    ok &= !juniper::binary::decode_tagged(clockBuf, clockN, 2, c);
+
+    CWatch::rawDayDateTimeCharacterstic.write(&packed, sizeof(packed));
+    ok &= Ble::readGeneric<CWatch::dayDateTimeBLE>(CWatch::dayDateTimeCharacterstic) == packed;
+    // A short value reads as zeros
+    CWatch::rawDayDateTimeCharacterstic.write(&packed, 3);
+    ok &= Ble::readGeneric<CWatch::dayDateTimeBLE>(CWatch::dayDateTimeCharacterstic) == CWatch::dayDateTimeBLE(0, 0, 0, 0, 0, 0);
+
+    uint32_t checksum = 0;
+    uint8_t buf[juniper::binary::codec<clock>::max_size];
+    double encodeNs = timeCalls(200000, checksum, [&](uint32_t i) {
+        CWatch::clockState.seconds = (uint8_t) i;
+        return (uint32_t) juniper::binary::encode(CWatch::clockState, buf) + buf[i % sizeof(buf)];
+    });
+    double decodeNs = timeCalls(200000, checksum, [&](uint32_t i) {
+        buf[0] = (uint8_t) (i % 28);
+        return juniper::binary::decode(buf, sizeof(buf), c) ? c.day : 0;
+    });
+    a = history(List::replicate<int32_t, 256>(16, 7), 0);
+    double listNs = timeCalls(200000, checksum, [&](uint32_t i) {
+        a.data.length = i & 15;
+        return (uint32_t) juniper::binary::encode(a, listBuf);
+    });
+    printf("\n%-24s %8s %8s\n", "binary", "ns", "max");
+    printf("%-24s %8.1f %8u\n", "encode clock", encodeNs, (unsigned) juniper::binary::codec<clock>::max_size);
+    printf("%-24s %8.1f %8u\n", "decode clock", decodeNs, (unsigned) juniper::binary::codec<clock>::max_size);
+    printf("%-24s %8.1f %8u\n", "encode history (<16)", listNs, (unsigned) juniper::binary::codec<history>::max_size);
+    if (!ok) {
+        printf("binary round trip failed\n");
+    }
+    return ok && checksum != 0;
+}
+
+// Writes bytes of stack below its own frame
+static __attribute__((noinline)) uint32_t useStack(uint32_t bytes) {
+    volatile uint8_t *buf = (volatile uint8_t *) alloca(bytes);
+    for (uint32_t i = 0; i < bytes; i++) {
+        buf[i] = (uint8_t) (i + 1);
+    }
+    return buf[0];
+}
+
+enum stackScope {
+    scopeSmall,
+    scopeLarge
+};
+
+static __attribute__((noinline)) bool runStack() {
+    juniper::stack::paint();
+    juniper::stack::name(scopeSmall, "small");
+    juniper::stack::name(scopeLarge, "large");
+    juniper::stack::sample();
+
+    // Frames and the margin add to each depth, but not by a whole kilobyte
+    uint32_t checksum = 0;
+    juniper::stack::enter(scopeSmall);
+    checksum += useStack(512);
+    juniper::stack::enter(scopeLarge);
+    checksum += useStack(6000);
+    juniper::stack::sample();
+    const juniper::stack::watch& w = juniper::stack::state;
+    uint32_t small = w.scopes[scopeSmall].deepest;
+    uint32_t large = w.scopes[scopeLarge].deepest;
+    bool ok = small >= 512 && small < 512 + 1024;
+    ok &= large >= 6000 && large < 6000 + 1024;
+    ok &= w.last == large && w.deepest == large;
+
+    // A shallower frame is measured again rather than remembered
+    {
+        juniper::stack::scope inner(scopeSmall);
+        checksum += useStack(2000);
+    }
+    juniper::stack::sample();
+    ok &= w.last >= 2000 && w.last < large && w.deepest == large;
+    ok &= w.scopes[scopeSmall].deepest >= 2000 && w.scopes[scopeLarge].deepest == large;
+
+    char report[256];
+    juniper::stack::format(report, sizeof(report));
+    printf("\n%s", report);
+    if (!ok) {
+        printf("stack depth check failed\n");
+    }
+    return ok && checksum != 0;
+}
+
+struct probe {
+    uint32_t value;
+};
+
+static bool runAllocations() {
+    typedef juniper::counted_cell<juniper::basic_container<probe>> cell;
+    typedef juniper::cow_array<int32_t, 64> shared;
+    const juniper::memory::allocation_totals& totals = juniper::memory::totals;
+    uint32_t liveBefore = totals.live;
+    uint32_t bytesBefore = totals.live_bytes;
+    uint32_t cellsBefore = juniper::memory::stats_for(sizeof(cell)).allocations;
+    bool ok = true;
+
+    juniper::memory::frame_begin();
+    {
+        juniper::refcell<probe> a(probe{ 1 });
+        juniper::refcell<probe> b = a;
+        juniper::refcell<probe> c(probe{ 2 });
+        ok &= totals.live == liveBefore + 2 && totals.live_bytes == bytesBefore + 2 * sizeof(cell);
+        auto p = juniper::make_rcptr(&finalized, juniper::function<void, juniper::unit(void *)>(countFinalize));
+        ok &= totals.live == liveBefore + 3;
+        // Reading an empty array allocates nothing
+        shared x;
+        ok &= x[0] == 0 && totals.live == liveBefore + 3;
+        x.data()[0] = 1;
+        shared y = x;
+        ok &= y.shared() && totals.live == liveBefore + 4;
+        y.data()[1] = 2;
+        ok &= totals.live == liveBefore + 5 && !x.shared();
+        ok &= x[0] == 1 && x[1] == 0 && y[0] == 1 && y[1] == 2;
+    }
+    juniper::memory::frame_end();
+    ok &= totals.last_frame_allocations == 5;
+    ok &= totals.live == liveBefore && totals.live_bytes == bytesBefore;
+    const juniper::memory::size_stats& cells = juniper::memory::stats_for(sizeof(cell));
+    ok &= cells.allocations >= cellsBefore + 2 && cells.peak_bytes >= 2 * sizeof(cell);
+
+    juniper::memory::frame_begin();
+    juniper::memory::frame_end();
+    ok &= totals.last_frame_allocations == 0 && totals.peak_frame_allocations >= 5;
+
+    // Leave one cell alive so that the report lists a size
+    juniper::refcell<probe> kept(probe{ 3 });
+    char report[512];
+    juniper::memory::format_allocations(report, sizeof(report));
+    printf("\n%s", report);
+    if (!ok) {
+        printf("allocation tracking check failed\n");
+    }
+    return ok;
+}
+
+int main() {
+    // Whatever was allocated before main, such as by globals, is still
+    // live at the end
+    uint32_t liveBefore = juniper::memory::totals.live;
+    printf("%-12s %8s %10s %10s %10s\n", "cells", "window", "heap ns", "pool ns", "arena ns");
+    bool ok = true;
+    ok &= runCase("short-lived", 4);
+    ok &= runCase("frame", 64);
+    // More live cells than the pool and arena hold, so both overflow
+    ok &= runCase("overflow", 1024);
+    ok &= checkFinalizer();
+    ok &= runCounts();
+    ok &= runCombinators();
+    ok &= runAdts();
+    ok &= runSignals();
+    ok &= runLists();
+    ok &= runHashing();
+    ok &= runBinary();
+    ok &= runStack();
+    ok &= runAllocations();
+    // Every block made by the cases above has been freed
+    ok &= juniper::memory::totals.live == liveBefore;
+
+    char stats[512];
+    juniper::memory::format(stats, sizeof(stats));
+    printf("\n%s", stats);
+    return ok ? 0 : 1;
+}
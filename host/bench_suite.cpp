@@ -0,0 +1,25 @@
+// Host runner for the runtime microbenchmark suite in bench_cases.h.
+// Prints the results as JSON to stdout, with times in nanoseconds, so
+// that runs on different commits can be compared case by case.
+//
+//   bench_suite [prefix]
+//
+// runs only the cases whose names start with prefix, e.g. List:: or
+// variant. sketch/bench runs the same cases on the watch in cycles.
+#include "../jun/main.cpp"
+#include "bench_cases.h"
+#include <chrono>
+
+static uint32_t nowNs() {
+    return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void emit(const char *line) {
+    fputs(line, stdout);
+}
+
+int main(int argc, char **argv) {
+    bench::runAll(nowNs, "ns", argc > 1 ? argv[1] : "", emit);
+    return 0;
+}
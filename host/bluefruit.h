@@ -0,0 +1,106 @@
+// Host stand-in for the Bluefruit nRF52 library. Characteristics are
+// plain byte buffers; host_inject_write lets a driver play the part of
+// the phone by writing a value and firing the write callback.
+#ifndef HOST_BLUEFRUIT_H
+#define HOST_BLUEFRUIT_H
+
+#include <stdint.h>
+#include <string.h>
+#include "bluefruit_common.h"
+
+class BLEUuid {
+public:
+    BLEUuid(uint16_t uuid16) : _uuid16(uuid16), _uuid128(nullptr) {}
+    BLEUuid(const uint8_t uuid128[16]) : _uuid16(0), _uuid128(uuid128) {}
+    uint16_t _uuid16;
+    const uint8_t* _uuid128;
+};
+
+class BLEService {
+public:
+    BLEService(BLEUuid uuid) : uuid(uuid) {}
+    int begin() { return 0; }
+    BLEUuid uuid;
+};
+
+class BLECharacteristic {
+public:
+    typedef void (*write_cb_t)(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data, uint16_t len);
+
+    BLECharacteristic(BLEUuid uuid) : uuid(uuid) {}
+
+    int begin() { return 0; }
+    void setProperties(uint8_t prop) { _properties = prop; }
+    void setPermission(SecureMode_t read_perm, SecureMode_t write_perm) { (void) read_perm; (void) write_perm; }
+    void setFixedLen(uint16_t fixed_len) { _len = fixed_len; }
+    void setMaxLen(uint16_t max_len) { (void) max_len; }
+    void setWriteCallback(write_cb_t fp) { _wr_cb = fp; }
+
+    uint16_t write(const void* data, uint16_t len) {
+        if (len > sizeof(_value)) {
+            len = sizeof(_value);
+        }
+        memcpy(_value, data, len);
+        _len = len;
+        return len;
+    }
+    bool notify(const void* data, uint16_t len) { (void) data; (void) len; return true; }
+    uint16_t write8(uint8_t num) { return write(&num, 1); }
+    uint16_t write16(uint16_t num) { return write(&num, 2); }
+    uint16_t write32(uint32_t num) { return write(&num, 4); }
+    uint16_t write32(int num) { return write(&num, 4); }
+
+    uint16_t read(void* buffer, uint16_t bufsize) {
+        uint16_t n = bufsize < _len ? bufsize : _len;
+        memcpy(buffer, _value, n);
+        return n;
+    }
+
+    // Host only: behave as if the central wrote data to this characteristic.
+    void host_inject_write(const void* data, uint16_t len) {
+        write(data, len);
+        if (_wr_cb != nullptr) {
+            _wr_cb(0, this, _value, _len);
+        }
+    }
+
+    BLEUuid uuid;
+
+private:
+    uint8_t _properties = 0;
+    uint8_t _value[244] = {};
+    uint16_t _len = 0;
+    write_cb_t _wr_cb = nullptr;
+};
+
+class BLEPeriph {
+public:
+    bool setConnInterval(uint16_t min, uint16_t max) { (void) min; (void) max; return true; }
+};
+
+class BLEAdvertising {
+public:
+    bool addFlags(uint8_t flags) { (void) flags; return true; }
+    bool addTxPower() { return true; }
+    bool addAppearance(uint16_t appearance) { (void) appearance; return true; }
+    bool addService(BLEService& service) { (void) service; return true; }
+    bool addName() { return true; }
+    void restartOnDisconnect(bool enable) { (void) enable; }
+    void setInterval(uint16_t fast, uint16_t slow) { (void) fast; (void) slow; }
+    void setFastTimeout(uint16_t sec) { (void) sec; }
+    bool start(uint16_t timeout = 0) { (void) timeout; return true; }
+};
+
+class AdafruitBluefruit {
+public:
+    bool begin() { return true; }
+    bool setTxPower(int8_t power) { (void) power; return true; }
+    void setName(const char* name) { (void) name; }
+
+    BLEPeriph Periph;
+    BLEAdvertising Advertising;
+};
+
+extern AdafruitBluefruit Bluefruit;
+
+#endif
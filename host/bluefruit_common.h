@@ -0,0 +1,87 @@
+// Host stand-in for the Bluefruit nRF52 common definitions.
+#ifndef HOST_BLUEFRUIT_COMMON_H
+#define HOST_BLUEFRUIT_COMMON_H
+
+#include <stdint.h>
+
+typedef enum {
+    SECMODE_NO_ACCESS = 0x00,
+    SECMODE_OPEN = 0x11,
+    SECMODE_ENC_NO_MITM = 0x21,
+    SECMODE_ENC_WITH_MITM = 0x31,
+    SECMODE_SIGNED_NO_MITM = 0x12,
+    SECMODE_SIGNED_WITH_MITM = 0x22
+} SecureMode_t;
+
+enum BleCharsProperties {
+    CHR_PROPS_BROADCAST = 0x01,
+    CHR_PROPS_READ = 0x02,
+    CHR_PROPS_WRITE_WO_RESP = 0x04,
+    CHR_PROPS_WRITE = 0x08,
+    CHR_PROPS_NOTIFY = 0x10,
+    CHR_PROPS_INDICATE = 0x20
+};
+
+#define BLE_GAP_ADV_FLAG_LE_LIMITED_DISC_MODE 0x01
+#define BLE_GAP_ADV_FLAG_LE_GENERAL_DISC_MODE 0x02
+#define BLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED 0x04
+#define BLE_GAP_ADV_FLAG_LE_BR_EDR_CONTROLLER 0x08
+#define BLE_GAP_ADV_FLAG_LE_BR_EDR_HOST 0x10
+#define BLE_GAP_ADV_FLAGS_LE_ONLY_LIMITED_DISC_MODE (BLE_GAP_ADV_FLAG_LE_LIMITED_DISC_MODE | BLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED)
+#define BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE (BLE_GAP_ADV_FLAG_LE_GENERAL_DISC_MODE | BLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED)
+
+#define BLE_APPEARANCE_UNKNOWN 0
+#define BLE_APPEARANCE_GENERIC_PHONE 64
+#define BLE_APPEARANCE_GENERIC_COMPUTER 128
+#define BLE_APPEARANCE_GENERIC_WATCH 192
+#define BLE_APPEARANCE_WATCH_SPORTS_WATCH 193
+#define BLE_APPEARANCE_GENERIC_CLOCK 256
+#define BLE_APPEARANCE_GENERIC_DISPLAY 320
+#define BLE_APPEARANCE_GENERIC_REMOTE_CONTROL 384
+#define BLE_APPEARANCE_GENERIC_EYE_GLASSES 448
+#define BLE_APPEARANCE_GENERIC_TAG 512
+#define BLE_APPEARANCE_GENERIC_KEYRING 576
+#define BLE_APPEARANCE_GENERIC_MEDIA_PLAYER 640
+#define BLE_APPEARANCE_GENERIC_BARCODE_SCANNER 704
+#define BLE_APPEARANCE_GENERIC_THERMOMETER 768
+#define BLE_APPEARANCE_THERMOMETER_EAR 769
+#define BLE_APPEARANCE_GENERIC_HEART_RATE_SENSOR 832
+#define BLE_APPEARANCE_HEART_RATE_SENSOR_HEART_RATE_BELT 833
+#define BLE_APPEARANCE_GENERIC_BLOOD_PRESSURE 896
+#define BLE_APPEARANCE_BLOOD_PRESSURE_ARM 897
+#define BLE_APPEARANCE_BLOOD_PRESSURE_WRIST 898
+#define BLE_APPEARANCE_GENERIC_HID 960
+#define BLE_APPEARANCE_HID_KEYBOARD 961
+#define BLE_APPEARANCE_HID_MOUSE 962
+#define BLE_APPEARANCE_HID_JOYSTICK 963
+#define BLE_APPEARANCE_HID_GAMEPAD 964
+#define BLE_APPEARANCE_HID_DIGITIZERSUBTYPE 965
+#define BLE_APPEARANCE_HID_CARD_READER 966
+#define BLE_APPEARANCE_HID_DIGITAL_PEN 967
+#define BLE_APPEARANCE_HID_BARCODE 968
+#define BLE_APPEARANCE_GENERIC_GLUCOSE_METER 1024
+#define BLE_APPEARANCE_GENERIC_RUNNING_WALKING_SENSOR 1088
+#define BLE_APPEARANCE_RUNNING_WALKING_SENSOR_IN_SHOE 1089
+#define BLE_APPEARANCE_RUNNING_WALKING_SENSOR_ON_SHOE 1090
+#define BLE_APPEARANCE_RUNNING_WALKING_SENSOR_ON_HIP 1091
+#define BLE_APPEARANCE_GENERIC_CYCLING 1152
+#define BLE_APPEARANCE_CYCLING_CYCLING_COMPUTER 1153
+#define BLE_APPEARANCE_CYCLING_SPEED_SENSOR 1154
+#define BLE_APPEARANCE_CYCLING_CADENCE_SENSOR 1155
+#define BLE_APPEARANCE_CYCLING_POWER_SENSOR 1156
+#define BLE_APPEARANCE_CYCLING_SPEED_CADENCE_SENSOR 1157
+#define BLE_APPEARANCE_GENERIC_PULSE_OXIMETER 3136
+#define BLE_APPEARANCE_PULSE_OXIMETER_FINGERTIP 3137
+#define BLE_APPEARANCE_PULSE_OXIMETER_WRIST_WORN 3138
+#define BLE_APPEARANCE_GENERIC_WEIGHT_SCALE 3200
+#define BLE_APPEARANCE_GENERIC_OUTDOOR_SPORTS_ACT 5184
+#define BLE_APPEARANCE_OUTDOOR_SPORTS_ACT_LOC_DISP 5185
+#define BLE_APPEARANCE_OUTDOOR_SPORTS_ACT_LOC_AND_NAV_DISP 5186
+#define BLE_APPEARANCE_OUTDOOR_SPORTS_ACT_LOC_POD 5187
+#define BLE_APPEARANCE_OUTDOOR_SPORTS_ACT_LOC_AND_NAV_POD 5188
+
+#define UUID16_SVC_CURRENT_TIME 0x1805
+#define UUID16_CHR_DAY_DATE_TIME 0x2A0A
+#define UUID16_CHR_DAY_OF_WEEK 0x2A09
+
+#endif
@@ -0,0 +1,41 @@
+#!/bin/sh
+# Builds the host (Linux) tools into host/out. ADAFRUIT_GFX must point at
+# a checkout of the Adafruit GFX library; the copy the Arduino IDE
+# installs under libraries/Adafruit_GFX_Library works.
+#
+#   out/cwatch        runs the sketch against an in-memory display, see
+#                     main_host.cpp for its options
+#   out/cwatch_bands  the same with band rendering (JUN_BAND_RENDER), so
+#                     frame times can be compared against out/cwatch
+#   out/cwatch_indexed  the same with an 8-bit indexed canvas
+#                     (JUN_INDEXED_CANVAS=8)
+#   out/bench_gfx     checks and times the Gfx drawing code
+#   out/bench_runtime  checks and times the Juniper runtime, starting
+#                     with the cell allocators (JUN_CELL_POOLS)
+#   out/bench_suite   times the runtime's building blocks at several
+#                     sizes and prints JSON, see bench_cases.h
+#
+# It also copies the generated sketch, the headers it includes and
+# bench_cases.h into sketch/bench, which runs the same cases on the
+# watch. check_frames.sh then checks that the present modes, band
+# rendering and retained drawing all produce the same frames.
+#
+# Extra compiler flags can be passed in CXXFLAGS; CXXFLAGS=-DJUN_PROFILE
+# makes out/cwatch print per-phase frame timings to stdout,
+# -DJUN_STACK_WATCH the deepest stack each phase reached, and
+# -DJUN_ALLOC_TRACK its allocations by size and per frame.
+set -e
+cd "$(dirname "$0")"
+GFX=${ADAFRUIT_GFX:-$HOME/Arduino/libraries/Adafruit_GFX_Library}
+CXX=${CXX:-g++}
+FLAGS="-std=gnu++11 -O2 -pthread -I. -I$GFX $CXXFLAGS"
+mkdir -p out
+$CXX $FLAGS host.cpp "$GFX/Adafruit_GFX.cpp" bench_gfx.cpp -o out/bench_gfx
+$CXX $FLAGS host.cpp "$GFX/Adafruit_GFX.cpp" bench_runtime.cpp -o out/bench_runtime
+$CXX $FLAGS host.cpp "$GFX/Adafruit_GFX.cpp" bench_suite.cpp -o out/bench_suite
+cp ../jun/main.cpp ../sketch/bench/cwatch_main.h
+cp ../jun/*.h ../sketch/bench/
+cp bench_cases.h ../sketch/bench/bench_cases.h
+$CXX $FLAGS host.cpp "$GFX/Adafruit_GFX.cpp" main_host.cpp -o out/cwatch
+$CXX $FLAGS -DJUN_BAND_RENDER host.cpp "$GFX/Adafruit_GFX.cpp" main_host.cpp -o out/cwatch_bands
+$CXX $FLAGS -DJUN_INDEXED_CANVAS=8 host.cpp "$GFX/Adafruit_GFX.cpp" main_host.cpp -o out/cwatch_indexed
@@ -0,0 +1,50 @@
+#!/bin/sh
+# Checks that the rendering options which should not change the picture
+# do not. Each run below dumps its frames and compares them byte for
+# byte with a reference run: out/cwatch as it is for the RGB565 builds,
+# and out/cwatch_indexed as it is for the indexed one, whose colours come
+# from its palette. Run host/build.sh first. Arguments are passed on to
+# every run, after the defaults of 300 frames with both buttons pressed.
+set -e
+cd "$(dirname "$0")"
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+ARGS="-n 300 -b 100 -a 150 $*"
+failed=0
+
+# run name binary [options]
+run() {
+    name=$1
+    shift
+    mkdir "$DIR/$name"
+    "$@" $ARGS -d "$DIR/$name" > /dev/null
+}
+
+# check reference name binary [options]
+check() {
+    reference=$1
+    shift
+    run "$@"
+    if diff -rq "$DIR/$reference" "$DIR/$1" > /dev/null; then
+        echo "ok        $1"
+    else
+        echo "MISMATCH  $1"
+        failed=1
+    fi
+}
+
+run cwatch out/cwatch
+check cwatch cwatch-blocking out/cwatch -p 0
+check cwatch cwatch-async out/cwatch -p 1
+check cwatch cwatch-chunked out/cwatch -p 2
+check cwatch cwatch-immediate out/cwatch -r 0
+check cwatch cwatch-retained out/cwatch -r 1
+check cwatch bands out/cwatch_bands
+check cwatch bands-immediate out/cwatch_bands -r 0
+check cwatch bands-retained out/cwatch_bands -r 1
+
+run indexed out/cwatch_indexed
+check indexed indexed-chunked out/cwatch_indexed -p 2
+check indexed indexed-retained out/cwatch_indexed -r 1
+
+exit $failed
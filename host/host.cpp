@@ -0,0 +1,257 @@
+// Host implementations of the Arduino, Bluefruit and Arcada stand-ins.
+// Time is virtual: millis() only advances when the driver says so, which
+// keeps runs deterministic regardless of how fast the host is.
+#include <Arduino.h>
+#include <Adafruit_Arcada.h>
+#include <bluefruit.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+uint32_t host_virtual_us = 0;
+uint32_t host_buttons = 0;
+uint32_t host_spi_ns_per_pixel = 0;
+uint8_t host_pins[64];
+
+HardwareSerial Serial;
+AdafruitBluefruit Bluefruit;
+
+uint32_t millis() { return host_virtual_us / 1000; }
+uint32_t micros() { return host_virtual_us; }
+void delay(uint32_t ms) { host_virtual_us += ms * 1000; }
+void yield() {}
+
+void pinMode(uint32_t pin, uint32_t mode) { (void) pin; (void) mode; }
+
+void digitalWrite(uint32_t pin, uint32_t val) {
+    if (pin < sizeof(host_pins)) {
+        host_pins[pin] = (uint8_t) val;
+    }
+}
+
+int digitalRead(uint32_t pin) { return pin < sizeof(host_pins) ? host_pins[pin] : LOW; }
+int analogRead(uint32_t pin) { (void) pin; return 0; }
+void analogWrite(uint32_t pin, int value) { (void) pin; (void) value; }
+
+static unsigned long host_rand_state = 1;
+
+void randomSeed(unsigned long seed) { host_rand_state = seed == 0 ? 1 : seed; }
+
+long random(long howbig) {
+    if (howbig <= 0) {
+        return 0;
+    }
+    // Park-Miller, so sequences are identical on every host libc
+    host_rand_state = (host_rand_state * 48271UL) % 2147483647UL;
+    return (long) (host_rand_state % (unsigned long) howbig);
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) {
+        return howsmall;
+    }
+    return random(howbig - howsmall) + howsmall;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    fputc(c, stderr);
+    return 1;
+}
+
+size_t Print::print(long n, int base) {
+    char buf[8 * sizeof(long) + 2];
+    if (base == 10) {
+        snprintf(buf, sizeof(buf), "%ld", n);
+    } else {
+        return print((unsigned long) n, base);
+    }
+    return write(buf);
+}
+
+size_t Print::print(unsigned long n, int base) {
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        unsigned long m = n;
+        n /= base;
+        char c = m - base * n;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return write(str);
+}
+
+size_t Print::print(double f, int digits) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, f);
+    return write(buf);
+}
+
+static uint32_t checksum(const uint16_t *colors, uint32_t len) {
+    uint32_t sum = 2166136261u;
+    for (uint32_t i = 0; i < len; i++) {
+        sum = (sum ^ colors[i]) * 16777619u;
+    }
+    return sum;
+}
+
+static void spiDelay(uint32_t len) {
+    if (host_spi_ns_per_pixel != 0) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds((uint64_t) len * host_spi_ns_per_pixel));
+    }
+}
+
+// The simulated DMA engine: one pending transfer, handed over under the
+// mutex and run by the worker thread.
+struct HostDma {
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool busy = false;
+    bool quit = false;
+    const uint16_t *colors = nullptr;
+    uint32_t len = 0;
+    bool bigEndian = false;
+    uint32_t sum = 0;
+};
+
+Adafruit_SPITFT::Adafruit_SPITFT(uint16_t w, uint16_t h)
+    : Adafruit_GFX(w, h), pixelsSent(0), windowsSent(0), dmaTorn(0), dmaOrderErrors(0),
+      _dma(new HostDma()), _winX(0), _winY(0), _winW(w), _winH(h), _winCursor(0) {
+    _panel = (uint16_t *) calloc((size_t) w * h, sizeof(uint16_t));
+    _dma->worker = std::thread([this]() {
+        std::unique_lock<std::mutex> guard(_dma->lock);
+        for (;;) {
+            _dma->wake.wait(guard, [this]() { return _dma->busy || _dma->quit; });
+            if (_dma->quit) {
+                return;
+            }
+            guard.unlock();
+            spiDelay(_dma->len);
+            if (checksum(_dma->colors, _dma->len) != _dma->sum) {
+                dmaTorn++;
+            }
+            send(_dma->colors, _dma->len, _dma->bigEndian);
+            guard.lock();
+            _dma->busy = false;
+            _dma->done.notify_all();
+        }
+    });
+}
+
+Adafruit_SPITFT::~Adafruit_SPITFT() {
+    {
+        std::lock_guard<std::mutex> guard(_dma->lock);
+        _dma->quit = true;
+    }
+    _dma->wake.notify_all();
+    _dma->worker.join();
+    delete _dma;
+    free(_panel);
+}
+
+void Adafruit_SPITFT::dmaWait() {
+    std::unique_lock<std::mutex> guard(_dma->lock);
+    _dma->done.wait(guard, [this]() { return !_dma->busy; });
+}
+
+bool Adafruit_SPITFT::dmaBusy() const {
+    std::lock_guard<std::mutex> guard(_dma->lock);
+    return _dma->busy;
+}
+
+void Adafruit_SPITFT::drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x >= 0 && y >= 0 && x < width() && y < height()) {
+        _panel[x + y * width()] = color;
+    }
+}
+
+void Adafruit_SPITFT::setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    if (dmaBusy()) {
+        dmaOrderErrors++;
+        dmaWait();
+    }
+    _winX = x;
+    _winY = y;
+    _winW = w;
+    _winH = h;
+    _winCursor = 0;
+    windowsSent++;
+}
+
+void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block, bool bigEndian) {
+    // Like the device driver, a new write first waits out the last one
+    dmaWait();
+    pixelsSent += len;
+    if (block) {
+        spiDelay(len);
+        send(colors, len, bigEndian);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(_dma->lock);
+    _dma->colors = colors;
+    _dma->len = len;
+    _dma->bigEndian = bigEndian;
+    _dma->sum = checksum(colors, len);
+    _dma->busy = true;
+    _dma->wake.notify_all();
+}
+
+void Adafruit_SPITFT::send(const uint16_t *colors, uint32_t len, bool bigEndian) {
+    for (uint32_t i = 0; i < len; i++) {
+        uint16_t c = colors[i];
+        if (bigEndian) {
+            c = (uint16_t) ((c >> 8) | (c << 8));
+        }
+        int32_t pos = _winCursor++;
+        if (_winW > 0) {
+            drawPixel(_winX + pos % _winW, _winY + pos / _winW, c);
+        }
+    }
+}
+
+Adafruit_Arcada::Adafruit_Arcada()
+    : display(NULL), _canvas(NULL) {}
+
+bool Adafruit_Arcada::arcadaBegin() { return true; }
+
+void Adafruit_Arcada::displayBegin() {
+    if (display == NULL) {
+        display = new Adafruit_SPITFT(HOST_TFT_WIDTH, HOST_TFT_HEIGHT);
+    }
+}
+
+void Adafruit_Arcada::setBacklight(uint8_t brightness, bool saveToDisk) {
+    (void) brightness;
+    (void) saveToDisk;
+}
+
+bool Adafruit_Arcada::createFrameBuffer(uint16_t width, uint16_t height) {
+    delete _canvas;
+    _canvas = new GFXcanvas16(width, height);
+    return _canvas->getBuffer() != NULL;
+}
+
+bool Adafruit_Arcada::blitFrameBuffer(uint16_t x, uint16_t y, bool blocking, bool bigEndian, Adafruit_SPITFT *tft) {
+    if (tft == NULL) {
+        tft = display;
+    }
+    if (_canvas == NULL || tft == NULL) {
+        return false;
+    }
+    tft->startWrite();
+    tft->setAddrWindow(x, y, _canvas->width(), _canvas->height());
+    tft->writePixels(_canvas->getBuffer(), (uint32_t) _canvas->width() * _canvas->height(), blocking, bigEndian);
+    tft->endWrite();
+    return true;
+}
+
+uint32_t Adafruit_Arcada::readButtons() {
+    return host_buttons;
+}
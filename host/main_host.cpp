@@ -0,0 +1,167 @@
+// Host driver for the CWatch sketch. Runs setup() once and then loop()
+// for a number of frames against the in-memory panel in host.cpp. The
+// virtual clock behind millis() advances by a fixed step per frame, so
+// runs are repeatable; the reported frame times are real time spent in
+// loop(). Frames can be dumped as PPM images to check rendering changes.
+// The present mode can be switched at run time, and with a simulated SPI
+// speed the DMA transfers take real time, so their overlap with drawing
+// shows up in the frame times. Retained display list diffing can be
+// switched on or off the same way.
+
+// The generated sketch is compiled into this file, as in bench_gfx.cpp,
+// since the drawing code it reaches into is inline in the sketch's headers.
+#include "../jun/main.cpp"
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+using namespace arcada_gfx;
+
+extern uint32_t host_virtual_us;
+
+struct press {
+    uint32_t frame;
+    uint32_t mask;
+};
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [-n frames] [-s step_ms] [-d dir] [-e every] [-a frame] [-b frame]\n"
+        "          [-p mode] [-t ns] [-r on]\n"
+        "  -n  number of loop() iterations to run (default 600)\n"
+        "  -s  virtual milliseconds that pass per frame (default 16)\n"
+        "  -d  directory to dump frames into as PPM files\n"
+        "  -e  dump every nth frame (default 1)\n"
+        "  -a  hold button A for one frame at the given frame number\n"
+        "  -b  hold button B for one frame at the given frame number\n"
+        "  -p  present mode: 0 blocking, 1 async, 2 chunked (default: the sketch's)\n"
+        "  -t  simulated SPI time per pixel in nanoseconds (default 0)\n"
+        "  -r  1 to retain and diff the display list, 0 to draw immediately\n"
+        "      (default: the sketch's)\n",
+        argv0);
+}
+
+static bool dumpPpm(const char *dir, uint32_t frame, const Adafruit_SPITFT *tft) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame%05u.ppm", dir, (unsigned) frame);
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    int w = tft->width();
+    int h = tft->height();
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    const uint16_t *px = tft->panel();
+    for (int i = 0; i < w * h; i++) {
+        uint16_t c = px[i];
+        uint8_t rgb[3] = {
+            (uint8_t) (((c >> 11) & 0x1F) * 255 / 31),
+            (uint8_t) (((c >> 5) & 0x3F) * 255 / 63),
+            (uint8_t) ((c & 0x1F) * 255 / 31)
+        };
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    uint32_t frames = 600;
+    uint32_t stepMs = 16;
+    uint32_t dumpEvery = 1;
+    const char *dumpDir = NULL;
+    std::vector<press> presses;
+    int presentMode = -1;
+    int retained = -1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *val = argv[++i];
+        switch (arg[1]) {
+            case 'n': frames = (uint32_t) strtoul(val, NULL, 10); break;
+            case 's': stepMs = (uint32_t) strtoul(val, NULL, 10); break;
+            case 'd': dumpDir = val; break;
+            case 'e': dumpEvery = std::max(1UL, strtoul(val, NULL, 10)); break;
+            case 'a': presses.push_back({ (uint32_t) strtoul(val, NULL, 10), ARCADA_BUTTONMASK_A }); break;
+            case 'b': presses.push_back({ (uint32_t) strtoul(val, NULL, 10), ARCADA_BUTTONMASK_B }); break;
+            case 'p': presentMode = (int) strtol(val, NULL, 10); break;
+            case 't': host_spi_ns_per_pixel = (uint32_t) strtoul(val, NULL, 10); break;
+            case 'r': retained = (int) strtol(val, NULL, 10); break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+
+    setup();
+    if (presentMode >= 0 && !presentBegin((uint8_t) presentMode)) {
+        fprintf(stderr, "present mode %d is not available, falling back\n", presentMode);
+    }
+    if (retained >= 0) {
+        listSetRetained(retained != 0);
+    }
+
+    std::vector<double> frameUs;
+    frameUs.reserve(frames);
+
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        host_buttons = 0;
+        for (const press &p : presses) {
+            if (p.frame == frame) {
+                host_buttons |= p.mask;
+            }
+        }
+
+        Adafruit_SPITFT *tft = arcada.display;
+
+        auto start = std::chrono::steady_clock::now();
+        loop();
+        auto end = std::chrono::steady_clock::now();
+
+        frameUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        host_virtual_us += stepMs * 1000;
+
+        if (dumpDir != NULL && frame % dumpEvery == 0) {
+            // The frame is only on the panel once its transfers are done
+            presentWait(presentFence());
+            if (!dumpPpm(dumpDir, frame, tft)) {
+                fprintf(stderr, "could not write frame %u to %s\n", (unsigned) frame, dumpDir);
+                return 1;
+            }
+        }
+    }
+
+    if (frameUs.empty()) {
+        return 0;
+    }
+
+    double total = 0;
+    for (double us : frameUs) {
+        total += us;
+    }
+    std::vector<double> sorted(frameUs);
+    std::sort(sorted.begin(), sorted.end());
+    double mean = total / frameUs.size();
+
+    printf("frames          %u\n", (unsigned) frameUs.size());
+    printf("fps             %.1f\n", 1e6 / mean);
+    printf("frame us min    %.1f\n", sorted.front());
+    printf("frame us mean   %.1f\n", mean);
+    printf("frame us p99    %.1f\n", sorted[std::min(sorted.size() * 99 / 100, sorted.size() - 1)]);
+    printf("frame us max    %.1f\n", sorted.back());
+    // Transfers still queued when the last frame ends count towards it
+    presentWait(presentFence());
+    Adafruit_SPITFT *tft = arcada.display;
+    printf("spi px/frame    %.0f\n", (double) tft->pixelsSent / frameUs.size());
+    if (listDropped != 0) {
+        printf("list dropped    %u\n", (unsigned) listDropped);
+    }
+    if (tft->dmaTorn != 0 || tft->dmaOrderErrors != 0) {
+        printf("dma torn        %u\n", (unsigned) tft->dmaTorn);
+        printf("dma order errs  %u\n", (unsigned) tft->dmaOrderErrors);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+#ifndef ARCADA_BANDS_H
+#define ARCADA_BANDS_H
+
+#include "arcada_list.h"
+
+namespace arcada_gfx
+{
+    // Band rendering. A full-screen canvas costs width x height x 2 bytes,
+    // about 115 KB for a 240x240 panel. Band mode does without one: every
+    // Gfx drawing call goes into the display list, and at present time the
+    // damaged part of the screen is rendered from it one strip of
+    // JUN_BAND_ROWS rows at a time. A strip starts out as background, every
+    // call that reaches it is replayed into it, and its damaged part is sent
+    // while the next strip is rendered into the other of two strip buffers.
+    inline bool bandCreate() {
+        bandMode = stripCreate(0) != NULL && stripCreate(1) != NULL;
+        return bandMode;
+    }
+
+    // Renders and sends every strip the damage list reaches
+    inline bool bandPresent() {
+        presentWait(present.submitted);
+        present.submitted++;
+
+        Adafruit_SPITFT *tft = arcada.display;
+        int16_t width = canvasLayout()->width();
+        int16_t height = canvasLayout()->height();
+        uint8_t which = 0;
+
+        tft->startWrite();
+        for (int16_t y0 = 0; y0 < height; y0 += JUN_BAND_ROWS) {
+            int16_t y1 = y0 + JUN_BAND_ROWS < height ? y0 + JUN_BAND_ROWS : height;
+            bool damaged = false;
+            for (uint8_t i = 0; i < damage.count; i++) {
+                damaged = damaged || (damage.rects[i].y0 < y1 && y0 < damage.rects[i].y1);
+            }
+            if (!damaged) {
+                continue;
+            }
+
+            // Only one transfer runs at a time, and it reads the other buffer
+            GFXcanvas16 *band = stripBuffers[which];
+            which ^= 1;
+            uint16_t *buffer = band->getBuffer();
+            listReplayRows(*listShown, band, y0, y0, y1, 0, width);
+
+            for (uint8_t i = 0; i < damage.count; i++) {
+                const damageRect& r = damage.rects[i];
+                int16_t ry0 = r.y0 > y0 ? r.y0 : y0;
+                int16_t ry1 = r.y1 < y1 ? r.y1 : y1;
+                if (ry0 >= ry1) {
+                    continue;
+                }
+                int16_t w = r.x1 - r.x0;
+                tft->dmaWait();
+                tft->setAddrWindow(r.x0, ry0, w, ry1 - ry0);
+                if (w == width) {
+                    tft->writePixels(&buffer[(int32_t) (ry0 - y0) * width], (uint32_t) w * (ry1 - ry0), false, false);
+                } else {
+                    // Each row waits for the one before it, so only the last
+                    // is worth leaving to DMA
+                    for (int16_t y = ry0; y < ry1; y++) {
+                        tft->writePixels(&buffer[(int32_t) (y - y0) * width + r.x0], w, y + 1 < ry1, false);
+                    }
+                }
+            }
+        }
+
+        // The last transfer finishes in the background; presentPump ends the
+        // write once it has
+        present.queue.count = 0;
+        present.next = 0;
+        present.writing = true;
+        damage.count = 0;
+        return true;
+    }
+
+    // Sends the damage list with the configured present mode and empties it
+    inline bool presentDamage() {
+        listFinish();
+        if (bandMode) {
+            return bandPresent();
+        }
+        if (present.mode == JUN_PRESENT_BLOCKING || (arcada.getCanvas() == NULL && indexedCanvas == NULL)) {
+            return damageBlit();
+        }
+
+        presentWait(present.submitted);
+        present.submitted++;
+        if (present.mode == JUN_PRESENT_ASYNC) {
+            presentAsync();
+        } else {
+            presentChunked();
+        }
+        damage.count = 0;
+        return true;
+    }
+}
+
+#endif
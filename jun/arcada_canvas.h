@@ -0,0 +1,36 @@
+#ifndef ARCADA_CANVAS_H
+#define ARCADA_CANVAS_H
+
+#include "Adafruit_Arcada.h"
+
+namespace arcada_gfx
+{
+    Adafruit_Arcada arcada;
+
+    // The text cursor and style live on a canvas of the screen's size that
+    // throws its pixels away, so that text can be laid out without drawing
+    // it: for the display list (see listRecord), and in band mode, which has
+    // no full-screen canvas at all.
+    class layoutCanvas : public Adafruit_GFX {
+    public:
+        layoutCanvas(int16_t w, int16_t h) : Adafruit_GFX(w, h) {}
+        void drawPixel(int16_t x, int16_t y, uint16_t color) override {}
+    };
+
+    layoutCanvas *textLayout = NULL;
+    bool bandMode = false;
+
+    inline Adafruit_GFX *canvasLayout() {
+        if (textLayout == NULL) {
+            GFXcanvas16 *canvas = arcada.getCanvas();
+            if (canvas != NULL) {
+                textLayout = new layoutCanvas(canvas->width(), canvas->height());
+            } else {
+                textLayout = new layoutCanvas(arcada.display->width(), arcada.display->height());
+            }
+        }
+        return textLayout;
+    }
+}
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef ARCADA_LIST_H
+#define ARCADA_LIST_H
+
+#include <string.h>
+#include "arcada_background.h"
+
+namespace arcada_gfx
+{
+    // Display list. Instead of drawing straight away, a Gfx drawing call can
+    // record itself as a replay function, the area it covers and a copy of
+    // its arguments. Calls are always recorded in band mode, and in
+    // full-buffer mode while listRetained is set (JUN_RETAINED sets it at
+    // start-up). When the frame is presented its list is compared with the
+    // previous frame's entry by entry. An entry with the same replay
+    // function, area and argument bytes as the one in the same position last
+    // frame is skipped; for the rest, the areas they cover now and covered
+    // then are rendered again and sent. A clock face that only changes one
+    // digit therefore repaints and sends only that digit.
+    //
+    // Clearing listRetained is the escape hatch back to immediate mode, where
+    // every call draws into the canvas at once and damages what it covers. In
+    // band mode, where there is no canvas, it turns the comparison off and
+    // every entry is rendered each frame. The change takes effect from the
+    // next frame. Calls that do not fit in the list are counted in
+    // listDropped; with a canvas they are drawn straight away, and in band
+    // mode they are lost.
+#ifndef JUN_LIST_MAX_OPS
+#define JUN_LIST_MAX_OPS 64
+#endif
+
+#ifndef JUN_LIST_ARG_BYTES
+#define JUN_LIST_ARG_BYTES 2048
+#endif
+
+    // Changed areas are rendered, and bands drawn, in strips of this many rows
+#ifndef JUN_BAND_ROWS
+#define JUN_BAND_ROWS 20
+#endif
+
+    // Dithering patterns repeat every four rows
+    static_assert(JUN_BAND_ROWS % 4 == 0, "JUN_BAND_ROWS must be a multiple of 4");
+
+    typedef void (*listReplay)(GFXcanvas16 *strip, int16_t dy, const void *args);
+
+    struct listOp {
+        listReplay replay;
+        damageRect area;
+        uint16_t args;
+        uint16_t size;
+    };
+
+    struct displayList {
+        listOp ops[JUN_LIST_MAX_OPS];
+        uint16_t count;
+        uint32_t args[JUN_LIST_ARG_BYTES / 4];
+        uint16_t used;
+    };
+
+#ifdef JUN_RETAINED
+    constexpr bool listRetainedDefault = true;
+#else
+    constexpr bool listRetainedDefault = false;
+#endif
+
+    bool listRetained = listRetainedDefault;
+    bool listRetainedNext = listRetainedDefault;
+    displayList lists[2];
+    displayList *listFrame = &lists[0];
+    displayList *listShown = &lists[1];
+    uint32_t listDropped = 0;
+    // Set when the last frame's list may no longer match the screen
+    bool listStale = false;
+    GFXcanvas16 *stripBuffers[2] = { NULL, NULL };
+
+    inline GFXcanvas16 *stripCreate(uint8_t i) {
+        if (stripBuffers[i] == NULL) {
+            stripBuffers[i] = new GFXcanvas16(canvasLayout()->width(), JUN_BAND_ROWS);
+        }
+        return stripBuffers[i]->getBuffer() != NULL ? stripBuffers[i] : NULL;
+    }
+
+    // The strips are RGB565, so an indexed canvas always draws immediately
+    inline bool listRecording() {
+        return bandMode || (listRetained && indexedCanvas == NULL && stripCreate(0) != NULL);
+    }
+
+    inline void listSetRetained(bool retained) {
+        listRetainedNext = retained;
+    }
+
+    // Makes every entry of the next frame count as changed. The list that
+    // was last shown is kept, both for the band renderer to replay and so
+    // that the areas it covered are redrawn too.
+    inline void listForget() {
+        listStale = true;
+    }
+
+    // Adds a drawing call covering (x, y, w, h) to the display list, with
+    // size bytes of args followed by tailSize bytes of tail as its arguments,
+    // and returns true. Returns false when calls are not being recorded or
+    // the list is full and there is a canvas, in which case the caller draws
+    // straight away.
+    inline bool listRecord(listReplay replay, int32_t x, int32_t y, int32_t w, int32_t h, const void *args, uint16_t size, const void *tail = NULL, uint16_t tailSize = 0) {
+        if (!listRecording()) {
+            return false;
+        }
+
+        damageRect area;
+        if (!damageClip(x, y, w, h, area)) {
+            return true;
+        }
+
+        uint16_t words = (size + tailSize + 3) / 4;
+        if (listFrame->count == JUN_LIST_MAX_OPS || listFrame->used + words > JUN_LIST_ARG_BYTES / 4) {
+            listDropped++;
+            return bandMode;
+        }
+
+        listOp& op = listFrame->ops[listFrame->count++];
+        op.replay = replay;
+        op.area = area;
+        op.args = listFrame->used;
+        op.size = size + tailSize;
+        memcpy(&listFrame->args[listFrame->used], args, size);
+        if (tailSize > 0) {
+            memcpy((uint8_t *) &listFrame->args[listFrame->used] + size, tail, tailSize);
+        }
+        listFrame->used += words;
+        return true;
+    }
+
+    inline bool listSame(const displayList& a, const listOp& x, const displayList& b, const listOp& y) {
+        return x.replay == y.replay
+            && x.size == y.size
+            && x.area.x0 == y.area.x0 && x.area.y0 == y.area.y0
+            && x.area.x1 == y.area.x1 && x.area.y1 == y.area.y1
+            && memcmp(&a.args[x.args], &b.args[y.args], x.size) == 0;
+    }
+
+    // Replays the entries of list that reach rows [y0, y1) into strip, whose
+    // first row is screen row top
+    inline void listReplayRows(const displayList& list, GFXcanvas16 *strip, int16_t top, int16_t y0, int16_t y1, int16_t x0, int16_t x1) {
+        int16_t width = strip->width();
+        uint16_t *buffer = strip->getBuffer();
+        for (int16_t y = y0; y < y1; y++) {
+            canvasFillSpan(&buffer[(int32_t) (y - top) * width + x0], x1 - x0, backgroundRows != NULL ? backgroundRows[y] : 0);
+        }
+        for (uint16_t i = 0; i < list.count; i++) {
+            const listOp& op = list.ops[i];
+            if (op.area.y0 < y1 && y0 < op.area.y1 && op.area.x0 < x1 && x0 < op.area.x1) {
+                op.replay(strip, -top, &list.args[op.args]);
+            }
+        }
+    }
+
+    // Renders area of the canvas again from the display list, a strip at a
+    // time, so that calls that reach outside it leave the rest untouched
+    inline void listRender(const displayList& list, const damageRect& area) {
+        GFXcanvas16 *canvas = arcada.getCanvas();
+        GFXcanvas16 *strip = stripBuffers[0];
+        int16_t width = canvas->width();
+        int16_t w = area.x1 - area.x0;
+        // Strips start on a multiple of four rows to keep dithering in step
+        for (int16_t top = area.y0 & ~3; top < area.y1; top += JUN_BAND_ROWS) {
+            int16_t y0 = top > area.y0 ? top : area.y0;
+            int16_t y1 = top + JUN_BAND_ROWS < area.y1 ? top + JUN_BAND_ROWS : area.y1;
+            listReplayRows(list, strip, top, y0, y1, area.x0, area.x1);
+            for (int16_t y = y0; y < y1; y++) {
+                memcpy(&canvas->getBuffer()[(int32_t) y * width + area.x0], &strip->getBuffer()[(int32_t) (y - top) * width + area.x0], w * sizeof(uint16_t));
+            }
+        }
+    }
+
+    // Puts back what the last frame's list drew over r, where immediate
+    // drawing went over it since. Returns false when there is no list to
+    // restore from, and the background alone is put back.
+    inline bool listRestore(const damageRect& r) {
+        if (!listRetained || listShown->count == 0) {
+            return false;
+        }
+        listRender(*listShown, r);
+        return true;
+    }
+
+    // Compares the frame's display list with the last one, damages the areas
+    // that changed, renders them into the canvas in full-buffer mode, and
+    // keeps the list for the next comparison
+    inline void listFinish() {
+        if (listFrame->count == 0 && listShown->count == 0) {
+            listRetained = listRetainedNext;
+            return;
+        }
+
+        damageList changed;
+        changed.count = 0;
+        bool compare = listRetained && !listStale;
+        uint16_t n = listFrame->count > listShown->count ? listFrame->count : listShown->count;
+        for (uint16_t i = 0; i < n; i++) {
+            const listOp *now = i < listFrame->count ? &listFrame->ops[i] : NULL;
+            const listOp *then = i < listShown->count ? &listShown->ops[i] : NULL;
+            if (compare && now != NULL && then != NULL && listSame(*listFrame, *now, *listShown, *then)) {
+                continue;
+            }
+            if (now != NULL) {
+                damageListAdd(changed, now->area);
+            }
+            if (then != NULL) {
+                damageListAdd(changed, then->area);
+            }
+        }
+
+        for (uint8_t i = 0; i < changed.count; i++) {
+            if (!bandMode) {
+                listRender(*listFrame, changed.rects[i]);
+            }
+            damageListAdd(damage, changed.rects[i]);
+        }
+
+        displayList *shown = listFrame;
+        listFrame = listShown;
+        listShown = shown;
+        listFrame->count = 0;
+        listFrame->used = 0;
+        listStale = false;
+
+        if (listRetained != listRetainedNext) {
+            // Immediate mode only restores the background where it saw
+            // drawing, so hand it what the list has on screen
+            if (backgroundRows != NULL) {
+                for (uint16_t i = 0; i < listShown->count; i++) {
+                    damageListAdd(backgroundOverdrawn, listShown->ops[i].area);
+                }
+            }
+            listRetained = listRetainedNext;
+            if (bandMode) {
+                // bandPresent has yet to replay this frame's list
+                listForget();
+            } else {
+                // The list is already in the canvas
+                listShown->count = 0;
+                listShown->used = 0;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef ARCADA_PALETTE_H
+#define ARCADA_PALETTE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "arcada_canvas.h"
+
+namespace arcada_gfx
+{
+    // Indexed canvas. Instead of RGB565, each pixel holds a 4- or 8-bit index
+    // into a palette of RGB565 colours, so the canvas takes a quarter or half
+    // the memory of a GFXcanvas16: about 29 or 58 KB for a 240x240 panel. The
+    // palette is expanded back to RGB565 a chunk at a time as the damaged
+    // rectangles are sent (see presentCopy).
+    //
+    // Drawing code hands colours to the canvas as palette indices. colorIndex
+    // finds a colour's index, adding the colour while the palette has room
+    // and falling back to the nearest entry once it is full; nearestIndex
+    // never adds. Recent lookups are cached by colour, and the cache is
+    // cleared whenever the palette changes. Index 0 starts out black, which
+    // is what a fresh canvas is filled with.
+#ifndef JUN_PALETTE_CACHE
+#define JUN_PALETTE_CACHE 64
+#endif
+
+    class paletteCanvas : public Adafruit_GFX {
+    public:
+        paletteCanvas(int16_t w, int16_t h, uint8_t bits) : Adafruit_GFX(w, h), bits(bits) {
+            stride = bits == 4 ? (w + 1) / 2 : w;
+            buffer = (uint8_t *) calloc((size_t) stride * h, 1);
+            palette = (uint16_t *) calloc((size_t) 1 << bits, sizeof(uint16_t));
+            colors = 1;
+            memset(cache, 0, sizeof(cache));
+        }
+
+        ~paletteCanvas() {
+            free(buffer);
+            free(palette);
+        }
+
+        uint8_t *getBuffer() const {
+            return palette != NULL ? buffer : NULL;
+        }
+
+        uint8_t getBits() const {
+            return bits;
+        }
+
+        uint16_t paletteCapacity() const {
+            return (uint16_t) 1 << bits;
+        }
+
+        uint16_t paletteSize() const {
+            return colors;
+        }
+
+        uint16_t paletteColor(uint8_t index) const {
+            return palette[index];
+        }
+
+        // Empties the palette down to black. Pixels keep their indices, so
+        // whatever is on the canvas has to be drawn again.
+        void paletteClear() {
+            colors = 1;
+            palette[0] = 0;
+            memset(cache, 0, sizeof(cache));
+        }
+
+        uint8_t colorIndex(uint16_t c) {
+            uint32_t& slot = cacheSlot(c);
+            // A cached nearest entry only stands in for c once nothing more
+            // can be added
+            if (cacheHit(slot, c) && (palette[slot & 0xFF] == c || colors == paletteCapacity())) {
+                return slot & 0xFF;
+            }
+            for (uint16_t i = 0; i < colors; i++) {
+                if (palette[i] == c) {
+                    slot = cacheEntry(c, i);
+                    return i;
+                }
+            }
+            if (colors < paletteCapacity()) {
+                palette[colors] = c;
+                memset(cache, 0, sizeof(cache));
+                return colors++;
+            }
+            return nearestIndex(c);
+        }
+
+        uint8_t nearestIndex(uint16_t c) {
+            uint32_t& slot = cacheSlot(c);
+            if (cacheHit(slot, c)) {
+                return slot & 0xFF;
+            }
+            // Squared distance with red and blue scaled to green's six bits,
+            // weighted roughly by how much each channel shows
+            int32_t r = (c >> 10) & 0x3E;
+            int32_t g = (c >> 5) & 0x3F;
+            int32_t b = (c << 1) & 0x3E;
+            uint8_t best = 0;
+            int32_t bestDistance = INT32_MAX;
+            for (uint16_t i = 0; i < colors; i++) {
+                int32_t dr = ((palette[i] >> 10) & 0x3E) - r;
+                int32_t dg = ((palette[i] >> 5) & 0x3F) - g;
+                int32_t db = ((palette[i] << 1) & 0x3E) - b;
+                int32_t distance = 3 * dr * dr + 4 * dg * dg + 2 * db * db;
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = i;
+                }
+            }
+            slot = cacheEntry(c, best);
+            return best;
+        }
+
+        // Sets n pixels of row y from x on to index, unclipped and unrotated
+        void fillSpan(int16_t x, int16_t y, int16_t n, uint8_t index) {
+            if (n <= 0) {
+                return;
+            }
+            uint8_t *row = &buffer[(int32_t) y * stride];
+            if (bits == 8) {
+                memset(&row[x], index, n);
+                return;
+            }
+            // Two pixels per byte, the left one in the high nibble
+            if (x & 1) {
+                row[x >> 1] = (row[x >> 1] & 0xF0) | index;
+                x++;
+                n--;
+            }
+            memset(&row[x >> 1], index * 0x11, n >> 1);
+            if (n & 1) {
+                uint8_t& last = row[(x + n) >> 1];
+                last = (last & 0x0F) | (index << 4);
+            }
+        }
+
+        // Writes n pixels of row y from x on as RGB565 into dst
+        void expand(int16_t x, int16_t y, int16_t n, uint16_t *dst) const {
+            const uint8_t *row = &buffer[(int32_t) y * stride];
+            if (bits == 8) {
+                for (int16_t i = 0; i < n; i++) {
+                    dst[i] = palette[row[x + i]];
+                }
+                return;
+            }
+            const uint8_t *src = &row[x >> 1];
+            if (x & 1) {
+                *dst++ = palette[*src++ & 0x0F];
+                n--;
+            }
+            for (; n >= 2; n -= 2) {
+                uint8_t pair = *src++;
+                dst[0] = palette[pair >> 4];
+                dst[1] = palette[pair & 0x0F];
+                dst += 2;
+            }
+            if (n > 0) {
+                *dst = palette[*src >> 4];
+            }
+        }
+
+        // Sets n pixels of row y from x on to the palette entries nearest the
+        // RGB565 colours in src
+        void writeNearest(int16_t x, int16_t y, int16_t n, const uint16_t *src) {
+            if (n <= 0) {
+                return;
+            }
+            uint16_t last = src[0];
+            uint8_t index = nearestIndex(last);
+            int16_t start = 0;
+            for (int16_t i = 1; i <= n; i++) {
+                if (i == n || src[i] != last) {
+                    drawFastHLine(x + start, y, i - start, index);
+                    if (i < n) {
+                        last = src[i];
+                        index = nearestIndex(last);
+                        start = i;
+                    }
+                }
+            }
+        }
+
+        void drawPixel(int16_t x, int16_t y, uint16_t index) override {
+            if (buffer == NULL || x < 0 || y < 0 || x >= width() || y >= height()) {
+                return;
+            }
+            unrotate(x, y);
+            fillSpan(x, y, 1, index);
+        }
+
+        void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t index) override {
+            if (rotation != 0) {
+                Adafruit_GFX::drawFastHLine(x, y, w, index);
+                return;
+            }
+            if (y < 0 || y >= HEIGHT) {
+                return;
+            }
+            int16_t x1 = x + w > WIDTH ? WIDTH : x + w;
+            x = x < 0 ? 0 : x;
+            fillSpan(x, y, x1 - x, index);
+        }
+
+        void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t index) override {
+            for (int16_t i = 0; i < h; i++) {
+                drawPixel(x, y + i, index);
+            }
+        }
+
+        void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t index) override {
+            int16_t y1 = y + h > height() ? height() : y + h;
+            for (y = y < 0 ? 0 : y; y < y1; y++) {
+                drawFastHLine(x, y, w, index);
+            }
+        }
+
+        void fillScreen(uint16_t index) override {
+            for (int16_t y = 0; y < HEIGHT; y++) {
+                fillSpan(0, y, WIDTH, index);
+            }
+        }
+
+    private:
+        uint8_t *buffer;
+        uint16_t *palette;
+        uint8_t bits;
+        uint16_t colors;
+        int16_t stride;
+        // Colour in bits 8-23 and index in bits 0-7 of a used entry
+        uint32_t cache[JUN_PALETTE_CACHE];
+
+        uint32_t& cacheSlot(uint16_t c) {
+            return cache[((uint32_t) c * 40503u >> 10) % JUN_PALETTE_CACHE];
+        }
+
+        static bool cacheHit(uint32_t slot, uint16_t c) {
+            return (slot & 0x80000000) != 0 && ((slot >> 8) & 0xFFFF) == c;
+        }
+
+        static uint32_t cacheEntry(uint16_t c, uint8_t index) {
+            return 0x80000000 | ((uint32_t) c << 8) | index;
+        }
+
+        // Maps rotated coordinates to the buffer's, as GFXcanvas16 does
+        void unrotate(int16_t& x, int16_t& y) const {
+            int16_t t;
+            switch (rotation) {
+                case 1:
+                    t = x;
+                    x = WIDTH - 1 - y;
+                    y = t;
+                    break;
+                case 2:
+                    x = WIDTH - 1 - x;
+                    y = HEIGHT - 1 - y;
+                    break;
+                case 3:
+                    t = x;
+                    x = y;
+                    y = HEIGHT - 1 - t;
+                    break;
+            }
+        }
+    };
+
+    paletteCanvas *indexedCanvas = NULL;
+
+    inline bool indexedCreate(uint8_t bits) {
+        if (indexedCanvas == NULL && (bits == 4 || bits == 8)) {
+            indexedCanvas = new paletteCanvas(arcada.display->width(), arcada.display->height(), bits);
+            if (indexedCanvas->getBuffer() == NULL) {
+                delete indexedCanvas;
+                indexedCanvas = NULL;
+            }
+        }
+        return indexedCanvas != NULL;
+    }
+}
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef ARCADA_PRESENT_H
+#define ARCADA_PRESENT_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "arcada_damage.h"
+
+namespace arcada_gfx
+{
+    // Presenting. damageBlit sends the damaged rectangles straight out of the
+    // canvas and returns once the display has them, so the CPU idles for the
+    // whole SPI transfer. The asynchronous modes hand the transfer to the
+    // display's DMA instead and let the next frame be drawn while it drains:
+    //
+    //  - JUN_PRESENT_ASYNC packs the damaged rectangles into a second,
+    //    screen-sized buffer and queues them from there, one DMA transfer per
+    //    rectangle. DMA never reads the canvas, so drawing can carry on as
+    //    soon as presentDamage returns. Queued rectangles are started by
+    //    presentPump, which damageAdd calls, whenever the previous transfer
+    //    has finished.
+    //  - JUN_PRESENT_CHUNKED is the fallback for builds that cannot spare a
+    //    second framebuffer. Rectangles are copied through two halves of a
+    //    JUN_PRESENT_CHUNK_PIXELS buffer, one filling while the other is sent,
+    //    and only the last chunk overlaps the next frame. An indexed canvas
+    //    is always sent this way (or blocking), its palette expanded into the
+    //    chunks as they are filled.
+    //
+    // Every present is numbered by a fence. presentDone and presentWait tell
+    // whether everything a present queued has reached the display, and a
+    // present waits for the previous fence before it reuses the staging
+    // memory. presentBegin falls back from async to chunked to blocking when
+    // the buffers it needs cannot be allocated.
+    //
+    // Blocking is the default. On the nRF52 core writePixels does not return
+    // until the transfer is over, so the other modes would only add staging
+    // memory and a copy. Set JUN_PRESENT_MODE on targets whose display
+    // driver finishes DMA in the background.
+#define JUN_PRESENT_BLOCKING 0
+#define JUN_PRESENT_ASYNC 1
+#define JUN_PRESENT_CHUNKED 2
+
+#ifndef JUN_PRESENT_MODE
+#define JUN_PRESENT_MODE JUN_PRESENT_BLOCKING
+#endif
+
+#ifndef JUN_PRESENT_CHUNK_PIXELS
+#define JUN_PRESENT_CHUNK_PIXELS 1024
+#endif
+
+    struct presentState {
+        uint8_t mode;
+        uint16_t *staging;
+        // Rectangles of the latest present, with their offsets into staging
+        damageList queue;
+        uint32_t offsets[JUN_DAMAGE_MAX_RECTS];
+        uint8_t next;
+        bool writing;
+        uint32_t submitted;
+        uint32_t completed;
+    };
+
+    presentState present;
+
+    inline void presentPump() {
+        if (!present.writing) {
+            return;
+        }
+
+        Adafruit_SPITFT *tft = arcada.display;
+        if (tft->dmaBusy()) {
+            return;
+        }
+
+        if (present.next < present.queue.count) {
+            const damageRect& r = present.queue.rects[present.next];
+            int16_t w = r.x1 - r.x0;
+            int16_t h = r.y1 - r.y0;
+            tft->setAddrWindow(r.x0, r.y0, w, h);
+            tft->writePixels(&present.staging[present.offsets[present.next]], (uint32_t) w * h, false, false);
+            present.next++;
+        } else {
+            tft->endWrite();
+            present.writing = false;
+            present.completed = present.submitted;
+        }
+    }
+
+    inline uint32_t presentFence() {
+        return present.submitted;
+    }
+
+    inline bool presentDone(uint32_t fence) {
+        presentPump();
+        return (int32_t) (present.completed - fence) >= 0;
+    }
+
+    inline void presentWait(uint32_t fence) {
+        while (!presentDone(fence)) {
+            arcada.display->dmaWait();
+        }
+    }
+
+    // Copies n pixels of canvas row y from x on into dst as RGB565, expanding
+    // them through the palette if the canvas is indexed
+    inline void presentCopy(uint16_t *dst, int16_t x, int16_t y, uint32_t n) {
+        if (indexedCanvas != NULL) {
+            indexedCanvas->expand(x, y, n, dst);
+        } else {
+            GFXcanvas16 *canvas = arcada.getCanvas();
+            memcpy(dst, &canvas->getBuffer()[(int32_t) y * canvas->width() + x], n * sizeof(uint16_t));
+        }
+    }
+
+    // Copies rows of the damaged rectangles through the two chunk halves,
+    // starting a transfer each time a half fills
+    inline void presentChunked() {
+        Adafruit_SPITFT *tft = arcada.display;
+        uint16_t *half = present.staging;
+        uint32_t used = 0;
+
+        tft->startWrite();
+        for (uint8_t i = 0; i < damage.count; i++) {
+            const damageRect& r = damage.rects[i];
+            int16_t w = r.x1 - r.x0;
+            tft->dmaWait();
+            tft->setAddrWindow(r.x0, r.y0, w, r.y1 - r.y0);
+            for (int16_t y = r.y0; y < r.y1; y++) {
+                int16_t x = r.x0;
+                int16_t left = w;
+                while (left > 0) {
+                    uint32_t n = JUN_PRESENT_CHUNK_PIXELS - used;
+                    n = n < (uint32_t) left ? n : (uint32_t) left;
+                    presentCopy(&half[used], x, y, n);
+                    used += n;
+                    x += n;
+                    left -= n;
+                    if (used == JUN_PRESENT_CHUNK_PIXELS) {
+                        tft->dmaWait();
+                        tft->writePixels(half, used, false, false);
+                        half = half == present.staging ? present.staging + JUN_PRESENT_CHUNK_PIXELS : present.staging;
+                        used = 0;
+                    }
+                }
+            }
+            // The window changes with the next rectangle, so flush what is left
+            if (used > 0) {
+                tft->dmaWait();
+                tft->writePixels(half, used, false, false);
+                half = half == present.staging ? present.staging + JUN_PRESENT_CHUNK_PIXELS : present.staging;
+                used = 0;
+            }
+        }
+
+        present.queue.count = 0;
+        present.next = 0;
+        present.writing = true;
+    }
+
+    // Packs the damaged rectangles into staging and queues them
+    inline void presentAsync() {
+        GFXcanvas16 *canvas = arcada.getCanvas();
+        uint16_t *buffer = canvas->getBuffer();
+        int16_t stride = canvas->width();
+        uint32_t offset = 0;
+
+        for (uint8_t i = 0; i < damage.count; i++) {
+            const damageRect& r = damage.rects[i];
+            int16_t w = r.x1 - r.x0;
+            present.queue.rects[i] = r;
+            present.offsets[i] = offset;
+            for (int16_t y = r.y0; y < r.y1; y++) {
+                memcpy(&present.staging[offset], &buffer[(int32_t) y * stride + r.x0], w * sizeof(uint16_t));
+                offset += w;
+            }
+        }
+
+        present.queue.count = damage.count;
+        present.next = 0;
+        present.writing = true;
+        arcada.display->startWrite();
+        presentPump();
+    }
+
+    // Sets up the staging memory for a present mode, falling back to the
+    // next cheaper mode when it cannot be allocated. Returns false if the
+    // requested mode could not be set up.
+    inline bool presentBegin(uint8_t mode) {
+        presentWait(present.submitted);
+        free(present.staging);
+        present.staging = NULL;
+
+        uint8_t requested = mode;
+        GFXcanvas16 *canvas = arcada.getCanvas();
+        if (indexedCanvas != NULL) {
+            // A second screen-sized RGB565 buffer would undo the savings
+            mode = mode == JUN_PRESENT_BLOCKING ? mode : JUN_PRESENT_CHUNKED;
+        } else if (canvas == NULL) {
+            mode = JUN_PRESENT_BLOCKING;
+        } else if (mode == JUN_PRESENT_ASYNC) {
+            present.staging = (uint16_t *) malloc((size_t) canvas->width() * canvas->height() * sizeof(uint16_t));
+            if (present.staging == NULL) {
+                mode = JUN_PRESENT_CHUNKED;
+            }
+        }
+        if (mode == JUN_PRESENT_CHUNKED) {
+            present.staging = (uint16_t *) malloc(2 * JUN_PRESENT_CHUNK_PIXELS * sizeof(uint16_t));
+            if (present.staging == NULL) {
+                mode = JUN_PRESENT_BLOCKING;
+            }
+        }
+
+        present.mode = mode;
+        return mode == requested;
+    }
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef GFX_MEASURE_H
+#define GFX_MEASURE_H
+
+#include "gfx_text.h"
+
+namespace arcada_gfx
+{
+    // Text measurement from a font's glyph table alone, giving the bounds
+    // Adafruit_GFX::getTextBounds reports for text at size 1 without
+    // wrapping. It is one table lookup per character, where getTextBounds
+    // goes through the canvas's font state for every one. A NULL font is the
+    // built-in 6x8 font, whose characters are all the same size.
+    struct textBounds {
+        int16_t x;
+        int16_t y;
+        uint16_t w;
+        uint16_t h;
+    };
+
+    // The pen position and the extent covered so far, as in
+    // Adafruit_GFX::charBounds
+    struct measureState {
+        int16_t x;
+        int16_t y;
+        int16_t minX;
+        int16_t minY;
+        int16_t maxX;
+        int16_t maxY;
+    };
+
+    inline void measureCover(measureState& s, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+        s.minX = x0 < s.minX ? x0 : s.minX;
+        s.minY = y0 < s.minY ? y0 : s.minY;
+        s.maxX = x1 > s.maxX ? x1 : s.maxX;
+        s.maxY = y1 > s.maxY ? y1 : s.maxY;
+    }
+
+    inline textBounds textMeasure(const GFXfont *font, const char *str, int16_t x = 0, int16_t y = 0) {
+        measureState s = { x, y, 0x7FFF, 0x7FFF, -1, -1 };
+        for (; *str != '\0'; str++) {
+            uint8_t c = (uint8_t) *str;
+            if (c == '\r') {
+                continue;
+            }
+            if (c == '\n') {
+                s.x = 0;
+                s.y += font != NULL ? font->yAdvance : 8;
+            } else if (font == NULL) {
+                measureCover(s, s.x, s.y, s.x + 5, s.y + 7);
+                s.x += 6;
+            } else if (c >= font->first && c <= font->last) {
+                const GFXglyph& g = font->glyph[c - font->first];
+                measureCover(s, s.x + g.xOffset, s.y + g.yOffset,
+                    s.x + g.xOffset + g.width - 1, s.y + g.yOffset + g.height - 1);
+                s.x += g.xAdvance;
+            }
+        }
+        textBounds b;
+        b.x = s.maxX >= s.minX ? s.minX : x;
+        b.y = s.maxY >= s.minY ? s.minY : y;
+        b.w = s.maxX >= s.minX ? s.maxX - s.minX + 1 : 0;
+        b.h = s.maxY >= s.minY ? s.maxY - s.minY + 1 : 0;
+        return b;
+    }
+
+    // getTextBounds for the current text style. Measures from the font table
+    // when it can be sure Adafruit_GFX would not have wrapped the text.
+    inline void textBoundsAt(const char *str, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) {
+        Adafruit_GFX *canvas = canvasLayout();
+        if (text.font != NULL && text.size == 1) {
+            textBounds b = textMeasure(text.font, str, x, y);
+            if (!text.wrap || b.x + b.w <= canvas->width()) {
+                *x1 = b.x;
+                *y1 = b.y;
+                *w = b.w;
+                *h = b.h;
+                return;
+            }
+        }
+        canvas->getTextBounds(str, x, y, x1, y1, w, h);
+    }
+}
+
+#endif
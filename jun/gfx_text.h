@@ -0,0 +1,346 @@
+#ifndef GFX_TEXT_H
+#define GFX_TEXT_H
+
+#include <string.h>
+#include "arcada_list.h"
+#include "gfx_kernels.h"
+
+namespace arcada_gfx
+{
+    // Text state. Adafruit_GFX keeps these protected, so the Gfx setters
+    // record a copy for the glyph cache as they pass them on to the canvas.
+    struct textStyle {
+        const GFXfont *font;
+        uint16_t color;
+        uint8_t size;
+        bool wrap;
+    };
+
+    textStyle text = { NULL, 0xFFFF, 1, true };
+
+    inline void textSetFont(const GFXfont *font) {
+        canvasLayout()->setFont(font);
+        text.font = font;
+    }
+
+    inline void textSetColor(uint16_t color) {
+        canvasLayout()->setTextColor(color);
+        text.color = color;
+    }
+
+    inline void textSetSize(uint8_t size) {
+        canvasLayout()->setTextSize(size);
+        text.size = size > 0 ? size : 1;
+    }
+
+    inline void textSetWrap(bool wrap) {
+        canvasLayout()->setTextWrap(wrap);
+        text.wrap = wrap;
+    }
+
+    // Glyph cache. Adafruit_GFX decodes a glyph bit by bit and writes its
+    // pixels one at a time; the cache keeps each glyph in use as the
+    // horizontal runs of its set pixels, so drawing it again is a handful of
+    // span fills. Runs carry no colour, so one entry serves every text colour.
+    // The runs share a fixed budget of JUN_GLYPH_CACHE_BYTES, and the least
+    // recently drawn glyphs are evicted to make room.
+#ifndef JUN_GLYPH_CACHE_BYTES
+#define JUN_GLYPH_CACHE_BYTES 6144
+#endif
+
+#ifndef JUN_GLYPH_CACHE_ENTRIES
+#define JUN_GLYPH_CACHE_ENTRIES 48
+#endif
+
+    // A run of set pixels, relative to the top left of the glyph bitmap
+    struct glyphRun {
+        uint8_t y;
+        uint8_t x;
+        uint8_t w;
+    };
+
+    // Entries own consecutive blocks of runs, stored in insertion order
+    struct glyphEntry {
+        const GFXfont *font;
+        uint8_t c;
+        uint16_t first;
+        uint16_t count;
+        uint32_t lastUsed;
+    };
+
+    struct glyphCacheT {
+        glyphEntry entries[JUN_GLYPH_CACHE_ENTRIES];
+        glyphRun runs[JUN_GLYPH_CACHE_BYTES / sizeof(glyphRun)];
+        uint8_t entryCount;
+        uint16_t runCount;
+        uint32_t clock;
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+    };
+
+    glyphCacheT glyphCache;
+
+    const uint16_t glyphCacheRunCapacity = JUN_GLYPH_CACHE_BYTES / sizeof(glyphRun);
+
+    // Decodes a glyph bitmap into runs, writing them to out unless it is
+    // NULL. Returns the number of runs.
+    inline uint16_t glyphRasterize(const GFXfont *font, const GFXglyph *glyph, glyphRun *out) {
+        const uint8_t *bitmap = font->bitmap;
+        uint16_t offset = glyph->bitmapOffset;
+        uint16_t count = 0;
+        uint8_t bits = 0;
+        uint8_t bit = 0;
+        for (uint8_t y = 0; y < glyph->height; y++) {
+            int16_t start = -1;
+            for (uint8_t x = 0; x < glyph->width; x++) {
+                if (!(bit++ & 7)) {
+                    bits = pgm_read_byte(&bitmap[offset++]);
+                }
+                if (bits & 0x80) {
+                    if (start < 0) {
+                        start = x;
+                    }
+                } else if (start >= 0) {
+                    if (out != NULL) {
+                        out[count].y = y;
+                        out[count].x = start;
+                        out[count].w = x - start;
+                    }
+                    count++;
+                    start = -1;
+                }
+                bits <<= 1;
+            }
+            if (start >= 0) {
+                if (out != NULL) {
+                    out[count].y = y;
+                    out[count].x = start;
+                    out[count].w = glyph->width - start;
+                }
+                count++;
+            }
+        }
+        return count;
+    }
+
+    inline void glyphEvict(uint8_t index) {
+        glyphEntry victim = glyphCache.entries[index];
+        uint16_t tail = victim.first + victim.count;
+        memmove(&glyphCache.runs[victim.first], &glyphCache.runs[tail], (glyphCache.runCount - tail) * sizeof(glyphRun));
+        glyphCache.runCount -= victim.count;
+        glyphCache.entries[index] = glyphCache.entries[--glyphCache.entryCount];
+        for (uint8_t i = 0; i < glyphCache.entryCount; i++) {
+            if (glyphCache.entries[i].first > victim.first) {
+                glyphCache.entries[i].first -= victim.count;
+            }
+        }
+        glyphCache.evictions++;
+    }
+
+    inline void glyphEvictOldest() {
+        uint8_t oldest = 0;
+        for (uint8_t i = 1; i < glyphCache.entryCount; i++) {
+            if (glyphCache.entries[i].lastUsed < glyphCache.entries[oldest].lastUsed) {
+                oldest = i;
+            }
+        }
+        glyphEvict(oldest);
+    }
+
+    // Finds the runs for a glyph, rasterising it on a miss. Returns NULL for
+    // glyphs too large for the whole cache.
+    inline const glyphEntry *glyphLookup(const GFXfont *font, uint8_t c, const GFXglyph *glyph) {
+        glyphCache.clock++;
+        for (uint8_t i = 0; i < glyphCache.entryCount; i++) {
+            glyphEntry& entry = glyphCache.entries[i];
+            if (entry.font == font && entry.c == c) {
+                entry.lastUsed = glyphCache.clock;
+                glyphCache.hits++;
+                return &entry;
+            }
+        }
+        glyphCache.misses++;
+        uint16_t count = glyphRasterize(font, glyph, NULL);
+        if (count > glyphCacheRunCapacity) {
+            return NULL;
+        }
+        while (glyphCache.entryCount == JUN_GLYPH_CACHE_ENTRIES || glyphCache.runCount + count > glyphCacheRunCapacity) {
+            glyphEvictOldest();
+        }
+        glyphEntry& entry = glyphCache.entries[glyphCache.entryCount++];
+        entry.font = font;
+        entry.c = c;
+        entry.first = glyphCache.runCount;
+        entry.count = count;
+        entry.lastUsed = glyphCache.clock;
+        glyphRasterize(font, glyph, &glyphCache.runs[entry.first]);
+        glyphCache.runCount += count;
+        return &entry;
+    }
+
+    // Text drawing calls record the style and cursor they were made with
+    // and the string, so a replay draws exactly what printing straight away
+    // would have. The cursor itself lives on canvasLayout.
+    struct textArgs {
+        const GFXfont *font;
+        uint16_t color;
+        int16_t x;
+        int16_t y;
+        uint8_t size;
+        bool wrap;
+    };
+
+    inline textArgs textArgsAt(int16_t x, int16_t y) {
+        textArgs a = { text.font, text.color, x, y, text.size, text.wrap };
+        return a;
+    }
+
+    template<typename Canvas>
+    void textPrint(Canvas *canvas, int16_t dy, const textArgs& a, const char *str) {
+        canvas->setFont(a.font);
+        canvas->setTextColor(canvasColor(canvas, a.color));
+        canvas->setTextSize(a.size);
+        canvas->setTextWrap(a.wrap);
+        canvas->setCursor(a.x, a.y + dy);
+        canvas->print(str);
+    }
+
+    inline void replayPrint(GFXcanvas16 *canvas, int16_t dy, const void *args) {
+        const textArgs& a = *(const textArgs *) args;
+        textPrint(canvas, dy, a, (const char *) (&a + 1));
+    }
+
+    // Prints at the cursor through Adafruit_GFX and records the area covered
+    // by the glyphs as damaged
+    inline void printDamaged(const char *str) {
+        Adafruit_GFX *layout = canvasLayout();
+        int16_t x1, y1;
+        uint16_t w, h;
+        layout->getTextBounds(str, layout->getCursorX(), layout->getCursorY(), &x1, &y1, &w, &h);
+        textArgs a = textArgsAt(layout->getCursorX(), layout->getCursorY());
+        if (listRecord(replayPrint, x1, y1, w, h, &a, sizeof(a), str, strlen(str) + 1)) {
+            // Only moves the cursor
+            layout->print(str);
+        } else if (indexedCanvas != NULL) {
+            textPrint(indexedCanvas, 0, a, str);
+            layout->setCursor(indexedCanvas->getCursorX(), indexedCanvas->getCursorY());
+            damageAdd(x1, y1, w, h);
+        } else {
+            GFXcanvas16 *canvas = arcada.getCanvas();
+            textPrint(canvas, 0, a, str);
+            layout->setCursor(canvas->getCursorX(), canvas->getCursorY());
+            damageAdd(x1, y1, w, h);
+        }
+    }
+
+    // Lays out str from the pen position (x, y) in a custom font at size 1
+    // like Adafruit_GFX::print, leaving the new pen position in x and y and
+    // the area the glyphs cover in box as x0, y0, x1, y1. Unless canvas is
+    // NULL the glyphs are drawn into it from the cache, dy rows further down.
+    template<typename Canvas>
+    void textGlyphs(Canvas *canvas, int16_t dy, const textArgs& a, int32_t& x, int32_t& y, const char *str, int32_t box[4]) {
+        const GFXfont *font = a.font;
+        uint16_t color = canvas != NULL ? canvasColor(canvas, a.color) : 0;
+        int32_t width = canvasLayout()->width();
+        box[0] = INT32_MAX;
+        box[1] = INT32_MAX;
+        box[2] = INT32_MIN;
+        box[3] = INT32_MIN;
+        if (canvas != NULL) {
+            // For glyphs drawn by Adafruit_GFX when the cache is full
+            canvas->setFont(font);
+        }
+        for (; *str != '\0'; str++) {
+            uint8_t c = *str;
+            if (c == '\n') {
+                x = 0;
+                y += font->yAdvance;
+                continue;
+            }
+            if (c == '\r' || c < font->first || c > font->last) {
+                continue;
+            }
+            const GFXglyph *glyph = &font->glyph[c - font->first];
+            if (glyph->width > 0 && glyph->height > 0) {
+                if (a.wrap && x + glyph->xOffset + glyph->width > width) {
+                    x = 0;
+                    y += font->yAdvance;
+                }
+                int32_t gx = x + glyph->xOffset;
+                int32_t gy = y + glyph->yOffset;
+                if (canvas != NULL) {
+                    const glyphEntry *entry = glyphLookup(font, c, glyph);
+                    if (entry != NULL) {
+                        const glyphRun *run = &glyphCache.runs[entry->first];
+                        for (uint16_t i = 0; i < entry->count; i++, run++) {
+                            kernelHLine(canvas, gx + run->x, gy + run->y + dy, run->w, color);
+                        }
+                    } else {
+                        canvas->drawChar(x, y + dy, c, color, color, 1, 1);
+                    }
+                }
+                if (gx < box[0]) {
+                    box[0] = gx;
+                }
+                if (gy < box[1]) {
+                    box[1] = gy;
+                }
+                if (gx + glyph->width > box[2]) {
+                    box[2] = gx + glyph->width;
+                }
+                if (gy + glyph->height > box[3]) {
+                    box[3] = gy + glyph->height;
+                }
+            }
+            x += glyph->xAdvance;
+        }
+    }
+
+    inline void replayText(GFXcanvas16 *canvas, int16_t dy, const void *args) {
+        const textArgs& a = *(const textArgs *) args;
+        int32_t x = a.x;
+        int32_t y = a.y;
+        int32_t box[4];
+        textGlyphs(canvas, dy, a, x, y, (const char *) (&a + 1), box);
+    }
+
+    // Prints at the cursor like Adafruit_GFX::print, drawing custom font
+    // glyphs from the cache, and records the area they cover as damaged. The
+    // built-in font, scaled text and rotated canvases go through Adafruit_GFX.
+    inline void printCached(const char *str) {
+        Adafruit_GFX *layout = canvasLayout();
+        if (text.font == NULL || text.size != 1 || layout->getRotation() != 0) {
+            printDamaged(str);
+            return;
+        }
+        textArgs a = textArgsAt(layout->getCursorX(), layout->getCursorY());
+        int32_t x = a.x;
+        int32_t y = a.y;
+        int32_t box[4];
+        // When the call is recorded this only lays the text out, and the
+        // glyphs are drawn when it is replayed
+        bool recording = listRecording();
+        if (indexedCanvas != NULL) {
+            textGlyphs(indexedCanvas, 0, a, x, y, str, box);
+        } else {
+            textGlyphs(recording ? NULL : arcada.getCanvas(), 0, a, x, y, str, box);
+        }
+        layout->setCursor(x, y);
+        if (box[0] >= box[2]) {
+            return;
+        }
+        if (recording) {
+            if (listRecord(replayText, box[0], box[1], box[2] - box[0], box[3] - box[1], &a, sizeof(a), str, strlen(str) + 1)) {
+                return;
+            }
+            // The list is full, so draw it now
+            x = a.x;
+            y = a.y;
+            textGlyphs(arcada.getCanvas(), 0, a, x, y, str, box);
+        }
+        damageAdd(box[0], box[1], box[2] - box[0], box[3] - box[1]);
+    }
+}
+
+#endif
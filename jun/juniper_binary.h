@@ -0,0 +1,540 @@
+#ifndef JUNIPER_BINARY_H
+#define JUNIPER_BINARY_H
+
+// Ble pulls this in with include(), which the compiler emits after the
+// Juniper runtime whose records, lists and variants it encodes.
+#include <inttypes.h>
+#include <string.h>
+
+// Binary encoding of runtime values, for BLE payloads, flash snapshots and
+// replay logs. Integers and floats are written little-endian at their full
+// width, bools and variant ids as one byte. A variant is written as its id
+// followed by the alternative it holds, an ADT as its variant, and a list
+// as its length followed by just the elements in use. Tuples are written
+// field by field, and so is a record whose fields are described with a
+// fields<T> specialisation; any other record of plain data is written as
+// it lies in memory, which for a packed record of integers on a
+// little-endian target is the same thing. codec<T>::max_size, known at compile time, is the
+// most bytes a T can take, so buffers can be sized from it. encode writes
+// straight into the caller's buffer and decode into the caller's value;
+// decode fails if the bytes run out or hold an id or a length that T
+// cannot have. References, functions and records holding them have no
+// encoding.
+//
+// The compiler emits records as recordt_ templates that only know their
+// fields by name, so a record to be written field by field is described
+// from a .jun inline block, after the alias that names it:
+//
+//     namespace juniper { namespace binary {
+//         template<>
+//         struct fields<CWatch::datetime> {
+//             typedef CWatch::datetime T;
+//             typedef field_list<JUN_FIELD(T, month), JUN_FIELD(T, day)> list;
+//         };
+//     } }
+//
+// The fields are encoded in the order listed.
+#define JUN_FIELD(T, name) juniper::binary::field<decltype(&T::name), &T::name>
+
+namespace juniper
+{
+    namespace binary
+    {
+        template<size_t... sizes>
+        struct static_sum;
+
+        template<>
+        struct static_sum<> {
+            static const size_t value = 0;
+        };
+
+        template<size_t first, size_t... rest>
+        struct static_sum<first, rest...> {
+            static const size_t value = first + static_sum<rest...>::value;
+        };
+
+        template<bool condition, typename T = void>
+        struct enable_if {};
+
+        template<typename T>
+        struct enable_if<true, T> {
+            typedef T type;
+        };
+
+        template<typename T>
+        struct always_void {
+            typedef void type;
+        };
+
+        template<typename T>
+        struct is_pointer {
+            static const bool value = false;
+        };
+
+        template<typename T>
+        struct is_pointer<T*> {
+            static const bool value = true;
+        };
+
+        template<typename T>
+        struct is_array {
+            static const bool value = false;
+        };
+
+        template<typename T, size_t N>
+        struct is_array<array<T, N>> {
+            static const bool value = true;
+            typedef T element;
+            static const size_t capacity = N;
+        };
+
+        template<typename T>
+        struct is_variant {
+            static const bool value = false;
+        };
+
+        template<typename... Ts>
+        struct is_variant<variant<Ts...>> {
+            static const bool value = true;
+        };
+
+        template<typename T, typename = void>
+        struct codec;
+
+        // One field of a record, reached through a pointer to member
+        template<typename M, M m>
+        struct field;
+
+        template<typename R, typename F, F R::*m>
+        struct field<F R::*, m> {
+            typedef F type;
+
+            static F& of(R& r) {
+                return r.*m;
+            }
+
+            static const F& of(const R& r) {
+                return r.*m;
+            }
+        };
+
+        template<typename... Fs>
+        struct field_list;
+
+        template<>
+        struct field_list<> {
+            static const size_t max_size = 0;
+
+            template<typename R>
+            static uint8_t* encode(const R& r, uint8_t* at) {
+                return at;
+            }
+
+            template<typename R>
+            static bool decode(const uint8_t*& at, const uint8_t* end, R& r) {
+                return true;
+            }
+        };
+
+        template<typename F, typename... Fs>
+        struct field_list<F, Fs...> {
+            static const size_t max_size = codec<typename F::type>::max_size + field_list<Fs...>::max_size;
+
+            template<typename R>
+            static uint8_t* encode(const R& r, uint8_t* at) {
+                at = codec<typename F::type>::encode(F::of(r), at);
+                return field_list<Fs...>::encode(r, at);
+            }
+
+            template<typename R>
+            static bool decode(const uint8_t*& at, const uint8_t* end, R& r) {
+                return codec<typename F::type>::decode(at, end, F::of(r)) && field_list<Fs...>::decode(at, end, r);
+            }
+        };
+
+        // The fields T is written as, for records described as above and
+        // for tuples; undescribed types have no list
+        template<typename T>
+        struct fields {};
+
+#define JUN_TUPLE_FIELD(type, n) field<type T::*, &T::e##n>
+
+        template<typename a, typename b>
+        struct fields<tuple2<a, b>> {
+            typedef tuple2<a, b> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2)> list;
+        };
+
+        template<typename a, typename b, typename c>
+        struct fields<tuple3<a, b, c>> {
+            typedef tuple3<a, b, c> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2), JUN_TUPLE_FIELD(c, 3)> list;
+        };
+
+        template<typename a, typename b, typename c, typename d>
+        struct fields<tuple4<a, b, c, d>> {
+            typedef tuple4<a, b, c, d> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2), JUN_TUPLE_FIELD(c, 3),
+                JUN_TUPLE_FIELD(d, 4)> list;
+        };
+
+        template<typename a, typename b, typename c, typename d, typename e>
+        struct fields<tuple5<a, b, c, d, e>> {
+            typedef tuple5<a, b, c, d, e> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2), JUN_TUPLE_FIELD(c, 3),
+                JUN_TUPLE_FIELD(d, 4), JUN_TUPLE_FIELD(e, 5)> list;
+        };
+
+        template<typename a, typename b, typename c, typename d, typename e, typename f>
+        struct fields<tuple6<a, b, c, d, e, f>> {
+            typedef tuple6<a, b, c, d, e, f> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2), JUN_TUPLE_FIELD(c, 3),
+                JUN_TUPLE_FIELD(d, 4), JUN_TUPLE_FIELD(e, 5), JUN_TUPLE_FIELD(f, 6)> list;
+        };
+
+        template<typename a, typename b, typename c, typename d, typename e, typename f, typename g>
+        struct fields<tuple7<a, b, c, d, e, f, g>> {
+            typedef tuple7<a, b, c, d, e, f, g> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2), JUN_TUPLE_FIELD(c, 3),
+                JUN_TUPLE_FIELD(d, 4), JUN_TUPLE_FIELD(e, 5), JUN_TUPLE_FIELD(f, 6), JUN_TUPLE_FIELD(g, 7)> list;
+        };
+
+        template<typename a, typename b, typename c, typename d, typename e, typename f, typename g, typename h>
+        struct fields<tuple8<a, b, c, d, e, f, g, h>> {
+            typedef tuple8<a, b, c, d, e, f, g, h> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2), JUN_TUPLE_FIELD(c, 3),
+                JUN_TUPLE_FIELD(d, 4), JUN_TUPLE_FIELD(e, 5), JUN_TUPLE_FIELD(f, 6), JUN_TUPLE_FIELD(g, 7),
+                JUN_TUPLE_FIELD(h, 8)> list;
+        };
+
+        template<typename a, typename b, typename c, typename d, typename e, typename f, typename g, typename h,
+            typename i>
+        struct fields<tuple9<a, b, c, d, e, f, g, h, i>> {
+            typedef tuple9<a, b, c, d, e, f, g, h, i> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2), JUN_TUPLE_FIELD(c, 3),
+                JUN_TUPLE_FIELD(d, 4), JUN_TUPLE_FIELD(e, 5), JUN_TUPLE_FIELD(f, 6), JUN_TUPLE_FIELD(g, 7),
+                JUN_TUPLE_FIELD(h, 8), JUN_TUPLE_FIELD(i, 9)> list;
+        };
+
+        template<typename a, typename b, typename c, typename d, typename e, typename f, typename g, typename h,
+            typename i, typename j>
+        struct fields<tuple10<a, b, c, d, e, f, g, h, i, j>> {
+            typedef tuple10<a, b, c, d, e, f, g, h, i, j> T;
+            typedef field_list<JUN_TUPLE_FIELD(a, 1), JUN_TUPLE_FIELD(b, 2), JUN_TUPLE_FIELD(c, 3),
+                JUN_TUPLE_FIELD(d, 4), JUN_TUPLE_FIELD(e, 5), JUN_TUPLE_FIELD(f, 6), JUN_TUPLE_FIELD(g, 7),
+                JUN_TUPLE_FIELD(h, 8), JUN_TUPLE_FIELD(i, 9), JUN_TUPLE_FIELD(j, 10)> list;
+        };
+
+#undef JUN_TUPLE_FIELD
+
+        // What kind of generated type T is. The compiler gives a list the
+        // fields data, an array, and length, and an ADT the field data, a
+        // variant.
+        template<typename T, typename = void>
+        struct data_of {
+            typedef void type;
+        };
+
+        template<typename T>
+        struct data_of<T, typename always_void<decltype(((T*) 0)->data)>::type> {
+            typedef decltype(((T*) 0)->data) type;
+        };
+
+        template<typename T, typename = void>
+        struct described {
+            static const bool value = false;
+        };
+
+        template<typename T>
+        struct described<T, typename always_void<typename fields<T>::list>::type> {
+            static const bool value = true;
+        };
+
+        template<typename T>
+        struct shape {
+            typedef typename data_of<T>::type data;
+            static const bool record = described<T>::value;
+            static const bool list = !record && is_array<data>::value;
+            static const bool adt = !record && is_variant<data>::value;
+            static const bool plain = __is_class(T) && __is_trivially_copyable(T) && !record && !list && !adt &&
+                !is_array<T>::value && !is_variant<T>::value;
+        };
+
+        // Integers, enums and bools
+        template<typename T>
+        struct codec<T, typename enable_if<!__is_class(T) && !__is_union(T) && !is_pointer<T>::value>::type> {
+            static const size_t max_size = sizeof(T);
+
+            static uint8_t* encode(const T& v, uint8_t* at) {
+                uint64_t bits = (uint64_t) v;
+                for (size_t i = 0; i < sizeof(T); i++) {
+                    at[i] = (uint8_t) (bits >> (8 * i));
+                }
+                return at + sizeof(T);
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, T& v) {
+                if ((size_t) (end - at) < sizeof(T)) {
+                    return false;
+                }
+                uint64_t bits = 0;
+                for (size_t i = 0; i < sizeof(T); i++) {
+                    bits |= (uint64_t) at[i] << (8 * i);
+                }
+                v = (T) bits;
+                at += sizeof(T);
+                return true;
+            }
+        };
+
+        // Floats as the integer holding their bits
+        template<typename T, typename Bits>
+        struct float_codec {
+            static const size_t max_size = sizeof(Bits);
+
+            static uint8_t* encode(const T& v, uint8_t* at) {
+                Bits bits;
+                memcpy(&bits, &v, sizeof(bits));
+                return codec<Bits>::encode(bits, at);
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, T& v) {
+                Bits bits;
+                if (!codec<Bits>::decode(at, end, bits)) {
+                    return false;
+                }
+                memcpy(&v, &bits, sizeof(bits));
+                return true;
+            }
+        };
+
+        template<>
+        struct codec<float> : float_codec<float, uint32_t> {};
+
+        template<>
+        struct codec<double> : float_codec<double, uint64_t> {};
+
+        template<>
+        struct codec<unit> {
+            static const size_t max_size = 0;
+
+            static uint8_t* encode(const unit& v, uint8_t* at) {
+                return at;
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, unit& v) {
+                return true;
+            }
+        };
+
+        // Every element of an array, which has no length of its own
+        template<typename T, size_t N>
+        struct codec<array<T, N>> {
+            static const size_t max_size = N * codec<T>::max_size;
+
+            static uint8_t* encode(const array<T, N>& v, uint8_t* at) {
+                for (size_t i = 0; i < N; i++) {
+                    at = codec<T>::encode(v.data[i], at);
+                }
+                return at;
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, array<T, N>& v) {
+                for (size_t i = 0; i < N; i++) {
+                    if (!codec<T>::decode(at, end, v.data[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        };
+
+        template<typename T>
+        struct codec<T, typename enable_if<shape<T>::record>::type> {
+            typedef typename fields<T>::list list;
+
+            static const size_t max_size = list::max_size;
+
+            static uint8_t* encode(const T& v, uint8_t* at) {
+                return list::encode(v, at);
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, T& v) {
+                return list::decode(at, end, v);
+            }
+        };
+
+        template<typename T>
+        struct codec<T, typename enable_if<shape<T>::plain>::type> {
+            static const size_t max_size = sizeof(T);
+
+            static uint8_t* encode(const T& v, uint8_t* at) {
+                memcpy(at, &v, sizeof(T));
+                return at + sizeof(T);
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, T& v) {
+                if ((size_t) (end - at) < sizeof(T)) {
+                    return false;
+                }
+                memcpy(&v, at, sizeof(T));
+                at += sizeof(T);
+                return true;
+            }
+        };
+
+        // A list writes its length and then only the elements in use, and
+        // reads back with the slots past its length zeroed
+        template<typename T>
+        struct codec<T, typename enable_if<shape<T>::list>::type> {
+            typedef is_array<typename shape<T>::data> array_t;
+            typedef typename array_t::element element;
+
+            static const size_t max_size = codec<uint32_t>::max_size + array_t::capacity * codec<element>::max_size;
+
+            static uint8_t* encode(const T& v, uint8_t* at) {
+                uint32_t length = v.length < array_t::capacity ? v.length : array_t::capacity;
+                at = codec<uint32_t>::encode(length, at);
+                for (uint32_t i = 0; i < length; i++) {
+                    at = codec<element>::encode(v.data.data[i], at);
+                }
+                return at;
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, T& v) {
+                uint32_t length;
+                if (!codec<uint32_t>::decode(at, end, length) || length > array_t::capacity) {
+                    return false;
+                }
+                for (uint32_t i = 0; i < length; i++) {
+                    if (!codec<element>::decode(at, end, v.data.data[i])) {
+                        return false;
+                    }
+                }
+                if (length < array_t::capacity) {
+                    memset((void *) &v.data.data[length], 0, (array_t::capacity - length) * sizeof(element));
+                }
+                v.length = length;
+                return true;
+            }
+        };
+
+        template<typename T>
+        struct codec<T, typename enable_if<shape<T>::adt>::type> {
+            typedef typename shape<T>::data data;
+
+            static const size_t max_size = codec<data>::max_size;
+
+            static uint8_t* encode(const T& v, uint8_t* at) {
+                return codec<data>::encode(v.data, at);
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, T& v) {
+                return codec<data>::decode(at, end, v.data);
+            }
+        };
+
+        template<unsigned char n, typename... Ts>
+        struct variant_codec;
+
+        template<unsigned char n, typename F, typename... Ts>
+        struct variant_codec<n, F, Ts...> {
+            template<typename V>
+            static uint8_t* encode(unsigned char id, const V& v, uint8_t* at) {
+                if (id == n) {
+                    // The runtime's get has no const overload
+                    return codec<F>::encode(const_cast<V&>(v).template get<n>(), at);
+                }
+                return variant_codec<n + 1, Ts...>::encode(id, v, at);
+            }
+
+            template<typename V>
+            static bool decode(unsigned char id, const uint8_t*& at, const uint8_t* end, V& v) {
+                if (id == n) {
+                    F value;
+                    if (!codec<F>::decode(at, end, value)) {
+                        return false;
+                    }
+                    v = V::template create<n>(value);
+                    return true;
+                }
+                return variant_codec<n + 1, Ts...>::decode(id, at, end, v);
+            }
+        };
+
+        // Past the last alternative is the empty id, which has no payload
+        template<unsigned char n>
+        struct variant_codec<n> {
+            template<typename V>
+            static uint8_t* encode(unsigned char id, const V& v, uint8_t* at) {
+                return at;
+            }
+
+            template<typename V>
+            static bool decode(unsigned char id, const uint8_t*& at, const uint8_t* end, V& v) {
+                if (id != n) {
+                    return false;
+                }
+                v = V();
+                return true;
+            }
+        };
+
+        template<typename... Ts>
+        struct codec<variant<Ts...>> {
+            static const size_t max_size = 1 + static_max<codec<Ts>::max_size...>::value;
+
+            static uint8_t* encode(const variant<Ts...>& v, uint8_t* at) {
+                // Nor has its id
+                *at = const_cast<variant<Ts...>&>(v).id();
+                return variant_codec<0, Ts...>::encode(*at, v, at + 1);
+            }
+
+            static bool decode(const uint8_t*& at, const uint8_t* end, variant<Ts...>& v) {
+                if (at == end) {
+                    return false;
+                }
+                unsigned char id = *at++;
+                return variant_codec<0, Ts...>::decode(id, at, end, v);
+            }
+        };
+
+        // Writes v into buf, which holds at least codec<T>::max_size
+        // bytes, and returns the number of bytes written
+        template<typename T>
+        size_t encode(const T& v, uint8_t* buf) {
+            return codec<T>::encode(v, buf) - buf;
+        }
+
+        // Reads v from the first len bytes of buf; false if they do not
+        // hold a T, in which case v may be partly overwritten
+        template<typename T>
+        bool decode(const uint8_t* buf, size_t len, T& v) {
+            const uint8_t* at = buf;
+            return codec<T>::decode(at, buf + len, v);
+        }
+
+        // A value behind a two-byte version tag, so that bytes written with
+        // an older layout of T are refused rather than misread
+        template<typename T>
+        struct tagged_size {
+            static const size_t value = codec<uint16_t>::max_size + codec<T>::max_size;
+        };
+
+        template<typename T>
+        size_t encode_tagged(const T& v, uint16_t version, uint8_t* buf) {
+            uint8_t* at = codec<uint16_t>::encode(version, buf);
+            return codec<T>::encode(v, at) - buf;
+        }
+
+        template<typename T>
+        bool decode_tagged(const uint8_t* buf, size_t len, uint16_t version, T& v) {
+            const uint8_t* at = buf;
+            const uint8_t* end = buf + len;
+            uint16_t tag;
+            return codec<uint16_t>::decode(at, end, tag) && tag == version && codec<T>::decode(at, end, v);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef JUNIPER_PROFILE_H
+#define JUNIPER_PROFILE_H
+
+// Frame phase timing. Define JUN_PROFILE to record how long each named
+// phase of a frame takes; without it every function below is empty and
+// compiles away. Durations come from the DWT cycle counter on Cortex-M and
+// from steady_clock on the host, both kept in 32 bits: the cycle count
+// wraps every 67 s at 64 MHz and the host's nanosecond count every 4.29 s.
+// end() subtracts modulo 2^32, so a wrap between begin() and end() is
+// harmless, but a phase longer than one wrap period is misread. Each phase keeps its last
+// JUN_PROFILE_WINDOW samples in a ring buffer, and format() summarises
+// that window as min, mean and max microseconds plus a histogram.
+#ifndef JUN_PROFILE_PHASES
+#define JUN_PROFILE_PHASES 8
+#endif
+
+#ifndef JUN_PROFILE_WINDOW
+#define JUN_PROFILE_WINDOW 64
+#endif
+
+#ifndef JUN_PROFILE_CPU_HZ
+#define JUN_PROFILE_CPU_HZ 64000000
+#endif
+
+// Histogram bucket k counts samples under (JUN_PROFILE_BUCKET_US << k)
+// microseconds; the last bucket takes everything longer
+#ifndef JUN_PROFILE_BUCKET_US
+#define JUN_PROFILE_BUCKET_US 64
+#endif
+
+#define JUN_PROFILE_BUCKETS 8
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifdef JUN_PROFILE
+#include <stdio.h>
+#ifndef __arm__
+#include <chrono>
+#endif
+#endif
+
+namespace juniper
+{
+    namespace profile
+    {
+#ifdef JUN_PROFILE
+#ifdef __arm__
+        inline void start_clock() {
+            // DEMCR.TRCENA, then DWT_CTRL.CYCCNTENA
+            *(volatile uint32_t *) 0xE000EDFC |= (uint32_t) 1 << 24;
+            *(volatile uint32_t *) 0xE0001000 |= 1;
+        }
+
+        inline uint32_t now() {
+            return *(volatile uint32_t *) 0xE0001004;
+        }
+
+        inline uint32_t ticks_to_us(uint32_t ticks) {
+            return ticks / (JUN_PROFILE_CPU_HZ / 1000000);
+        }
+#else
+        inline void start_clock() {}
+
+        // Nanoseconds, wrapping every 4.29 s; see above
+        inline uint32_t now() {
+            return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        inline uint32_t ticks_to_us(uint32_t ticks) {
+            return ticks / 1000;
+        }
+#endif
+
+        struct phase {
+            const char *name;
+            uint32_t started;
+            uint32_t count;
+            uint32_t window[JUN_PROFILE_WINDOW];
+        };
+
+        phase phases[JUN_PROFILE_PHASES];
+
+        inline void name(uint8_t p, const char *phase_name) {
+            start_clock();
+            phases[p].name = phase_name;
+        }
+
+        inline void begin(uint8_t p) {
+            phases[p].started = now();
+        }
+
+        inline void end(uint8_t p) {
+            // Unsigned subtraction survives the counter wrapping
+            uint32_t ticks = now() - phases[p].started;
+            phases[p].window[phases[p].count % JUN_PROFILE_WINDOW] = ticks;
+            phases[p].count++;
+        }
+
+        // Writes one line per named phase that has samples:
+        //   name min mean max | histogram
+        // with times in microseconds. Output that does not fit in len
+        // (at least 1) is cut short. Returns the length written.
+        inline size_t format(char *buf, size_t len) {
+            size_t used = 0;
+            buf[0] = '\0';
+            for (uint8_t p = 0; p < JUN_PROFILE_PHASES && used < len; p++) {
+                const phase& ph = phases[p];
+                if (ph.name == nullptr || ph.count == 0) {
+                    continue;
+                }
+                uint32_t n = ph.count < JUN_PROFILE_WINDOW ? ph.count : JUN_PROFILE_WINDOW;
+                uint32_t lo = UINT32_MAX;
+                uint32_t hi = 0;
+                uint64_t total = 0;
+                uint16_t buckets[JUN_PROFILE_BUCKETS] = {};
+                for (uint32_t i = 0; i < n; i++) {
+                    uint32_t us = ticks_to_us(ph.window[i]);
+                    lo = us < lo ? us : lo;
+                    hi = us > hi ? us : hi;
+                    total += us;
+                    uint8_t k = 0;
+                    while (k < JUN_PROFILE_BUCKETS - 1 && us >= ((uint32_t) JUN_PROFILE_BUCKET_US << k)) {
+                        k++;
+                    }
+                    buckets[k]++;
+                }
+                used += snprintf(buf + used, len - used, "%s %lu %lu %lu |",
+                    ph.name, (unsigned long) lo, (unsigned long) (total / n), (unsigned long) hi);
+                for (uint8_t k = 0; k < JUN_PROFILE_BUCKETS && used < len; k++) {
+                    used += snprintf(buf + used, len - used, " %u", (unsigned) buckets[k]);
+                }
+                if (used < len) {
+                    used += snprintf(buf + used, len - used, "\n");
+                }
+                if (used >= len) {
+                    return len - 1;
+                }
+            }
+            return used;
+        }
+#else
+        inline void name(uint8_t p, const char *phase_name) {}
+        inline void begin(uint8_t p) {}
+        inline void end(uint8_t p) {}
+
+        inline size_t format(char *buf, size_t len) {
+            if (len > 0) {
+                buf[0] = '\0';
+            }
+            return 0;
+        }
+#endif
+
+        // Times the enclosing C++ scope as phase p
+        struct scope {
+            uint8_t p;
+
+            scope(uint8_t phase_id) : p(phase_id) {
+                begin(p);
+            }
+
+            ~scope() {
+                end(p);
+            }
+        };
+    }
+}
+
+#endif
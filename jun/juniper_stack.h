@@ -0,0 +1,199 @@
+#ifndef JUNIPER_STACK_H
+#define JUNIPER_STACK_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Stack depth. Define JUN_STACK_WATCH to find out how deep the stack
+// goes; without it every function below is empty and compiles away.
+// paint() fills the JUN_STACK_WATCH_BYTES below its caller with a canary
+// word, and the lowest word that no longer holds it marks the deepest the
+// stack has been since. Depths are in bytes below the frame paint() ran
+// in, so it should be called first thing in setup(). The painted area has
+// to fit in the stack that setup() and loop() run on (LOOP_STACK_SZ words
+// on the Adafruit nRF52 core); a depth equal to the whole budget means
+// the stack went past it.
+//
+// sample() records the depth reached since the last sample, the first
+// one being setup's and the rest one per loop(), and paints again. Named
+// scopes split that depth up: enter(s) charges the depth reached since
+// the last enter or sample to the scope that was current and makes s
+// current. Each repaint only covers the words the stack has dirtied,
+// below the caller, and each measurement scans up from the bottom of the
+// painted area to the first dirtied word.
+#ifndef JUN_STACK_WATCH_BYTES
+#ifdef __arm__
+#define JUN_STACK_WATCH_BYTES 4096
+#else
+#define JUN_STACK_WATCH_BYTES 65536
+#endif
+#endif
+
+#ifndef JUN_STACK_SCOPES
+#define JUN_STACK_SCOPES 8
+#endif
+
+// Left unpainted just below the frame that paints, which covers the
+// painting code's own locals and the x86-64 red zone
+#define JUN_STACK_MARGIN 256
+
+// The fill FreeRTOS gives new task stacks, so a debugger shows both alike
+#define JUN_STACK_CANARY 0xa5a5a5a5u
+
+#ifdef JUN_STACK_WATCH
+#include <stdio.h>
+#endif
+
+namespace juniper
+{
+    namespace stack
+    {
+        const uint8_t no_scope = 0xff;
+
+#ifdef JUN_STACK_WATCH
+        struct named_scope {
+            const char *name;
+            uint32_t deepest;
+        };
+
+        struct watch {
+            // The frame paint() ran in, the lowest painted word, and the
+            // lowest word that may have been dirtied since the last paint
+            uintptr_t base;
+            uintptr_t bottom;
+            uintptr_t clean_below;
+            uint8_t current;
+            uint32_t deepest;
+            uint32_t setup;
+            uint32_t last;
+            uint32_t since_sample;
+            uint32_t samples;
+            named_scope scopes[JUN_STACK_SCOPES];
+        };
+
+        watch state;
+
+        inline void fill(uintptr_t from, uintptr_t to) {
+            for (volatile uint32_t *p = (volatile uint32_t *) from; (uintptr_t) p < to; p++) {
+                *p = JUN_STACK_CANARY;
+            }
+        }
+
+        // Charges the depth reached since the last paint to the current
+        // scope, then paints from there up to margin bytes under the frame
+        // at top
+        inline void charge_and_repaint(uintptr_t top) {
+            volatile uint32_t *p = (volatile uint32_t *) state.bottom;
+            while ((uintptr_t) p < state.clean_below && *p == JUN_STACK_CANARY) {
+                p++;
+            }
+            uintptr_t dirty = (uintptr_t) p;
+            uint32_t depth = (uint32_t) (state.base - dirty);
+            state.since_sample = depth > state.since_sample ? depth : state.since_sample;
+            state.deepest = depth > state.deepest ? depth : state.deepest;
+            if (state.current != no_scope) {
+                named_scope& s = state.scopes[state.current];
+                s.deepest = depth > s.deepest ? depth : s.deepest;
+            }
+            top = (top < state.base ? top : state.base) - JUN_STACK_MARGIN;
+            if (top > dirty) {
+                fill(dirty, top);
+                state.clean_below = top;
+            } else {
+                state.clean_below = dirty;
+            }
+        }
+
+        __attribute__((noinline)) void paint() {
+            uintptr_t here = (uintptr_t) __builtin_frame_address(0) & ~(uintptr_t) 3;
+            state.base = here;
+            state.bottom = here - JUN_STACK_WATCH_BYTES;
+            state.clean_below = here - JUN_STACK_MARGIN;
+            state.current = no_scope;
+            fill(state.bottom, state.clean_below);
+        }
+
+        inline void name(uint8_t s, const char *scope_name) {
+            state.scopes[s].name = scope_name;
+        }
+
+        __attribute__((noinline)) void enter(uint8_t s) {
+            charge_and_repaint((uintptr_t) __builtin_frame_address(0));
+            state.current = s;
+        }
+
+        __attribute__((noinline)) void sample() {
+            charge_and_repaint((uintptr_t) __builtin_frame_address(0));
+            if (state.samples == 0) {
+                state.setup = state.since_sample;
+            } else {
+                state.last = state.since_sample;
+            }
+            state.samples++;
+            state.since_sample = 0;
+            state.current = no_scope;
+        }
+
+        // Writes a line for the whole stack and one per named scope that
+        // has been entered:
+        //   stack deepest setup last budget
+        //   stack name deepest
+        // in bytes. Output that does not fit in len (at least 1) is cut
+        // short. Returns the length written.
+        inline size_t format(char *buf, size_t len) {
+            size_t used = 0;
+            buf[0] = '\0';
+            if (state.samples == 0) {
+                return 0;
+            }
+            used += snprintf(buf, len, "stack %lu %lu %lu %lu\n",
+                (unsigned long) state.deepest, (unsigned long) state.setup,
+                (unsigned long) state.last, (unsigned long) JUN_STACK_WATCH_BYTES);
+            for (uint8_t s = 0; s < JUN_STACK_SCOPES && used < len; s++) {
+                const named_scope& ns = state.scopes[s];
+                if (ns.name == nullptr || ns.deepest == 0) {
+                    continue;
+                }
+                used += snprintf(buf + used, len - used, "stack %s %lu\n", ns.name, (unsigned long) ns.deepest);
+            }
+            return used < len ? used : len - 1;
+        }
+
+        inline uint8_t current() {
+            return state.current;
+        }
+#else
+        inline void paint() {}
+        inline void name(uint8_t s, const char *scope_name) {}
+        inline void enter(uint8_t s) {}
+        inline void sample() {}
+
+        inline size_t format(char *buf, size_t len) {
+            if (len > 0) {
+                buf[0] = '\0';
+            }
+            return 0;
+        }
+
+        inline uint8_t current() {
+            return no_scope;
+        }
+#endif
+
+        // Charges the enclosing C++ scope's depth to scope s, and what
+        // follows it to the scope that was current before
+        struct scope {
+            uint8_t previous;
+
+            scope(uint8_t s) : previous(current()) {
+                enter(s);
+            }
+
+            ~scope() {
+                enter(previous);
+            }
+        };
+    }
+}
+
+#endif
@@ -708,12 +708,32 @@ namespace juniper
 #include <Arduino.h>
 #include <Arduino.h>
 #include "Adafruit_Arcada.h"
+#include "arcada_canvas.h"
+#include "arcada_palette.h"
+#include "arcada_damage.h"
+#include "arcada_span.h"
+#include "arcada_present.h"
+#include "arcada_background.h"
+#include "arcada_list.h"
+#include "arcada_bands.h"
 #include <bluefruit.h>
 #include <bluefruit_common.h>
+#include "juniper_binary.h"
 #include <bluefruit.h>
+#include "juniper_memory.h"
+#include "juniper_profile.h"
+#include "juniper_stack.h"
+#include "juniper_hash.h"
+#include "juniper_cow.h"
+#include "juniper_atomic.h"
 #include <Adafruit_GFX.h>
 #include <Fonts/FreeSans9pt7b.h>
 #include <Fonts/FreeSans24pt7b.h>
+#include "gfx_kernels.h"
+#include "gfx_text.h"
+#include "gfx_measure.h"
+#include "gfx_gradient.h"
+#include "gfx_ops.h"
 
 namespace Prelude {}
 namespace List {}
@@ -2009,6 +2029,54 @@ namespace Gfx {
     }
 
 
+}
+
+namespace Gfx {
+    struct gradientDirection {
+        juniper::variant<uint8_t, uint8_t, uint8_t> data;
+
+        gradientDirection() {}
+
+        gradientDirection(juniper::variant<uint8_t, uint8_t, uint8_t> initData) : data(initData) {}
+
+        uint8_t gradientVertical() {
+            return data.template get<0>();
+        }
+
+        uint8_t gradientHorizontal() {
+            return data.template get<1>();
+        }
+
+        uint8_t gradientDiagonal() {
+            return data.template get<2>();
+        }
+
+        uint8_t id() {
+            return data.id();
+        }
+
+        bool operator==(gradientDirection rhs) {
+            return data == rhs.data;
+        }
+
+        bool operator!=(gradientDirection rhs) {
+            return !(this->operator==(rhs));
+        }
+    };
+
+    Gfx::gradientDirection gradientVertical() {
+        return Gfx::gradientDirection(juniper::variant<uint8_t, uint8_t, uint8_t>::template create<0>(0));
+    }
+
+    Gfx::gradientDirection gradientHorizontal() {
+        return Gfx::gradientDirection(juniper::variant<uint8_t, uint8_t, uint8_t>::template create<1>(0));
+    }
+
+    Gfx::gradientDirection gradientDiagonal() {
+        return Gfx::gradientDirection(juniper::variant<uint8_t, uint8_t, uint8_t>::template create<2>(0));
+    }
+
+
 }
 
 namespace Prelude {
@@ -3229,10 +3297,78 @@ namespace Arcada {
     bool createDoubleBuffer();
 }
 
+namespace Arcada {
+    bool createBands();
+}
+
+namespace Arcada {
+    bool createIndexedCanvas(uint8_t bits);
+}
+
+namespace Arcada {
+    bool createCanvas();
+}
+
+namespace Arcada {
+    juniper::unit setRetained(bool on);
+}
+
 namespace Arcada {
     bool blitDoubleBuffer();
 }
 
+namespace Arcada {
+    juniper::unit addDamage(int16_t x, int16_t y, int16_t w, int16_t h);
+}
+
+namespace Arcada {
+    juniper::unit clearDamage();
+}
+
+namespace Arcada {
+    bool blitDamage();
+}
+
+namespace Arcada {
+    bool beginPresent();
+}
+
+namespace Arcada {
+    uint32_t lastPresent();
+}
+
+namespace Arcada {
+    bool isPresented(uint32_t fence);
+}
+
+namespace Arcada {
+    juniper::unit waitPresented(uint32_t fence);
+}
+
+namespace Arcada {
+    bool createBackground();
+}
+
+namespace Arcada {
+    juniper::unit setBackgroundRow(int16_t y, uint16_t c);
+}
+
+namespace Arcada {
+    juniper::unit invalidateBackground();
+}
+
+namespace Arcada {
+    juniper::unit restoreBackground();
+}
+
+namespace Arcada {
+    bool hasBackground();
+}
+
+namespace Arcada {
+    uint32_t backgroundInvalidatedAt();
+}
+
 namespace Arcada {
     Prelude::sig<Io::pinState> readButtons(uint8_t buttonMask);
 }
@@ -3393,6 +3529,11 @@ namespace Gfx {
     juniper::tuple4<int16_t, int16_t, uint16_t, uint16_t> getCharListBounds(int16_t x, int16_t y, juniper::records::recordt_0<juniper::array<uint8_t, (1)+(c229)>, uint32_t> cl);
 }
 
+namespace Gfx {
+    template<int c260>
+    juniper::tuple4<int16_t, int16_t, uint16_t, uint16_t> measure(Gfx::font f, int16_t x, int16_t y, juniper::records::recordt_0<juniper::array<uint8_t, (1)+(c260)>, uint32_t> cl);
+}
+
 namespace Gfx {
     template<int c230>
     juniper::unit printCharList(juniper::records::recordt_0<juniper::array<uint8_t, (1)+(c230)>, uint32_t> cl);
@@ -3426,6 +3567,10 @@ namespace Gfx {
     juniper::unit fillCircle(uint16_t x0, uint16_t y0, uint16_t r, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c);
 }
 
+namespace Gfx {
+    juniper::unit fillRect(int16_t x, int16_t y, int16_t w, int16_t h, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c);
+}
+
 namespace CWatch {
     juniper::unit drawFlashlight();
 }
@@ -3435,7 +3580,26 @@ namespace Gfx {
 }
 
 namespace Gfx {
-    juniper::unit drawVerticalGradient(int16_t x0i, int16_t y0i, int16_t w, int16_t h, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c1, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c2);
+    template<int c256>
+    juniper::unit drawGradient(int16_t x, int16_t y, int16_t w, int16_t h, Gfx::gradientDirection dir, juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, c256>, uint32_t> stops, bool dither);
+}
+
+namespace Gfx {
+    juniper::unit drawVerticalGradient(int16_t x0, int16_t y0, int16_t w, int16_t h, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c1, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c2);
+}
+
+namespace Gfx {
+    template<int c257>
+    juniper::unit setGradientBackground(juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, c257>, uint32_t> stops);
+}
+
+namespace Gfx {
+    juniper::unit setVerticalGradientBackground(juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c1, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c2);
+}
+
+namespace Gfx {
+    template<int c259>
+    juniper::unit paletteFromGradient(juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, c259>, uint32_t> stops, uint16_t n);
 }
 
 namespace CWatch {
@@ -3458,6 +3622,11 @@ namespace Gfx {
     juniper::unit printString(const char * s);
 }
 
+namespace Gfx {
+    template<int c258>
+    juniper::unit drawRadialGradient(int16_t x, int16_t y, int16_t w, int16_t h, int16_t cx, int16_t cy, int16_t r, juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, c258>, uint32_t> stops, bool dither);
+}
+
 namespace Gfx {
     template<int c255>
     juniper::unit centerCursor(int16_t x, int16_t y, Gfx::align align, juniper::records::recordt_0<juniper::array<uint8_t, c255>, uint32_t> cl);
@@ -3857,7 +4026,13 @@ namespace CWatch {
 
 namespace Arcada {
     
-Adafruit_Arcada arcada;
+using namespace arcada_gfx;
+
+}
+
+namespace Gfx {
+    
+using namespace arcada_gfx;
 
 }
 
@@ -3880,6 +4055,108 @@ void onWriteDayOfWeek(uint16_t conn_hdl, BLECharacteristic* chr, uint8_t* data,
     rawHasNewDayOfWeek = true;
 }
 
+// The phases of a frame timed by juniper::profile, and measured by
+// juniper::stack as scopes of the same numbers. With JUN_PROFILE,
+// JUN_STACK_WATCH or JUN_ALLOC_TRACK defined the timings, depths and
+// allocation counts are printed to serial and published on a readable
+// BLE characteristic every JUN_PROFILE_REPORT_MS; otherwise the functions
+// below are empty.
+enum framePhase {
+    phaseFrame,
+    phaseBackground,
+    phaseBluetooth,
+    phaseSignals,
+    phaseDraw,
+    phaseBlit
+};
+
+#ifndef JUN_PROFILE_REPORT_MS
+#define JUN_PROFILE_REPORT_MS 5000
+#endif
+
+#ifndef JUN_PROFILE_NOTIFY_BYTES
+#define JUN_PROFILE_NOTIFY_BYTES 20
+#endif
+
+#if defined(JUN_PROFILE) || defined(JUN_STACK_WATCH) || defined(JUN_ALLOC_TRACK)
+// 7a1c0e52-4d3b-4f8e-9b26-5c0d8e31f4a7
+const uint8_t profileUuid[16] = { 0xa7, 0xf4, 0x31, 0x8e, 0x0d, 0x5c, 0x26, 0x9b, 0x8e, 0x4f, 0x3b, 0x4d, 0x52, 0x0e, 0x1c, 0x7a };
+const uint8_t profileReportUuid[16] = { 0xa7, 0xf4, 0x31, 0x8e, 0x0d, 0x5c, 0x26, 0x9b, 0x8e, 0x4f, 0x3b, 0x4d, 0x53, 0x0e, 0x1c, 0x7a };
+BLEService profileService(profileUuid);
+BLECharacteristic profileCharacteristic(profileReportUuid);
+char profileReport[244];
+uint32_t profileReportedAt = 0;
+uint8_t profilePhase = phaseFrame;
+#endif
+
+void profileBegin() {
+    juniper::profile::name(phaseFrame, "frame");
+    juniper::profile::name(phaseBackground, "background");
+    juniper::profile::name(phaseBluetooth, "bluetooth");
+    juniper::profile::name(phaseSignals, "signals");
+    juniper::profile::name(phaseDraw, "draw");
+    juniper::profile::name(phaseBlit, "blit");
+    juniper::stack::name(phaseBackground, "background");
+    juniper::stack::name(phaseBluetooth, "bluetooth");
+    juniper::stack::name(phaseSignals, "signals");
+    juniper::stack::name(phaseDraw, "draw");
+    juniper::stack::name(phaseBlit, "blit");
+#if defined(JUN_PROFILE) || defined(JUN_STACK_WATCH) || defined(JUN_ALLOC_TRACK)
+    Serial.begin(115200);
+    profileService.begin();
+    profileCharacteristic.setProperties(CHR_PROPS_READ | CHR_PROPS_NOTIFY);
+    profileCharacteristic.setPermission(SECMODE_OPEN, SECMODE_NO_ACCESS);
+    profileCharacteristic.setMaxLen(sizeof(profileReport));
+    profileCharacteristic.begin();
+#endif
+}
+
+// Ends the phase in progress and starts timing phase p. The first call
+// in a frame also starts the whole-frame timer.
+void profileEnter(uint8_t p) {
+#ifdef JUN_PROFILE
+    if (profilePhase != phaseFrame) {
+        juniper::profile::end(profilePhase);
+    } else {
+        juniper::profile::begin(phaseFrame);
+    }
+    juniper::profile::begin(p);
+    profilePhase = p;
+#endif
+    juniper::stack::enter(p);
+}
+
+void profileFrameEnd() {
+#ifdef JUN_PROFILE
+    juniper::profile::end(profilePhase);
+    juniper::profile::end(phaseFrame);
+    profilePhase = phaseFrame;
+#endif
+    juniper::stack::sample();
+#if defined(JUN_PROFILE) || defined(JUN_STACK_WATCH) || defined(JUN_ALLOC_TRACK)
+    if (millis() - profileReportedAt >= JUN_PROFILE_REPORT_MS) {
+        profileReportedAt = millis();
+        size_t len = juniper::profile::format(profileReport, sizeof(profileReport));
+        // Cell pool usage follows the phases when JUN_CELL_POOLS is on
+        len += juniper::memory::format(profileReport + len, sizeof(profileReport) - len);
+        len += juniper::stack::format(profileReport + len, sizeof(profileReport) - len);
+        len += juniper::memory::format_allocations(profileReport + len, sizeof(profileReport) - len);
+        Serial.print(profileReport);
+        profileCharacteristic.write(profileReport, len);
+        // A notification carries at most the ATT MTU less three bytes, 20
+        // unless a larger MTU was negotiated, so the report goes out in
+        // pieces of that size; a central that does not subscribe can read
+        // the whole report instead
+        for (size_t sent = 0; sent < len; sent += JUN_PROFILE_NOTIFY_BYTES) {
+            size_t piece = len - sent < JUN_PROFILE_NOTIFY_BYTES ? len - sent : JUN_PROFILE_NOTIFY_BYTES;
+            if (!profileCharacteristic.notify(profileReport + sent, piece)) {
+                break;
+            }
+        }
+    }
+#endif
+}
+
 }
 
 namespace Prelude {
@@ -9191,16 +9468,16 @@ namespace Arcada {
 }
 
 namespace Arcada {
-    bool blitDoubleBuffer() {
+    bool createBands() {
         return (([&]() -> bool {
-            bool guid218 = true;
+            bool guid376 = true;
             if (!(true)) {
                 juniper::quit<juniper::unit>();
             }
-            bool ret = guid218;
+            bool ret = guid376;
             
             (([&]() -> juniper::unit {
-                ret = arcada.blitFrameBuffer(0, 0, true, false);
+                ret = bandCreate();
                 return {};
             })());
             return ret;
@@ -9209,88 +9486,354 @@ namespace Arcada {
 }
 
 namespace Arcada {
-    Prelude::sig<Io::pinState> readButtons(uint8_t buttonMask) {
-        return (([&]() -> Prelude::sig<Io::pinState> {
-            uint8_t pressedButtons;
+    bool createIndexedCanvas(uint8_t bits) {
+        return (([&]() -> bool {
+            bool guid378 = true;
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool ret = guid378;
             
             (([&]() -> juniper::unit {
-                pressedButtons = arcada.readButtons();
+                ret = indexedCreate(bits);
                 return {};
             })());
-            return signal<Io::pinState>(just<Io::pinState>((((bool) (((uint8_t) (pressedButtons & buttonMask)) == ((uint8_t) 0))) ? 
-                Io::low()
-            :
-                Io::high())));
+            return ret;
         })());
     }
 }
 
 namespace Arcada {
-    uint8_t JUN_ARCADA_BUTTONMASK_A = ((uint8_t) 1);
-}
-
-namespace Arcada {
-    uint8_t JUN_ARCADA_BUTTONMASK_B = ((uint8_t) 2);
+    bool createCanvas() {
+        return (([&]() -> bool {
+            bool guid379 = false;
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool banded = guid379;
+            
+            uint8_t guid380 = ((uint8_t) 0);
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            uint8_t indexedBits = guid380;
+            
+            (([&]() -> juniper::unit {
+                
+#ifdef JUN_BAND_RENDER
+    banded = true;
+#endif
+#ifdef JUN_INDEXED_CANVAS
+    indexedBits = JUN_INDEXED_CANVAS;
+#endif
+    
+                return {};
+            })());
+            return (banded ? 
+                createBands()
+            :
+                (((bool) (indexedBits != ((uint8_t) 0))) ? 
+                    createIndexedCanvas(indexedBits)
+                :
+                    createDoubleBuffer()));
+        })());
+    }
 }
 
 namespace Arcada {
-    Prelude::sig<Io::pinState> readButtonA() {
-        return readButtons(JUN_ARCADA_BUTTONMASK_A);
+    juniper::unit setRetained(bool on) {
+        return (([&]() -> juniper::unit {
+            listSetRetained(on);
+            return {};
+        })());
     }
 }
 
 namespace Arcada {
-    Prelude::sig<Io::pinState> readButtonB() {
-        return readButtons(JUN_ARCADA_BUTTONMASK_B);
+    bool blitDoubleBuffer() {
+        return (([&]() -> bool {
+            bool guid218 = true;
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool ret = guid218;
+            
+            (([&]() -> juniper::unit {
+                
+    presentWait(presentFence());
+    ret = arcada.blitFrameBuffer(0, 0, true, false);
+    damage.count = 0;
+    
+                return {};
+            })());
+            return ret;
+        })());
     }
 }
 
-namespace Ble {
-    Ble::advertisingFlagt bleGapAdvFlagLeLimitedDiscMode = (([]() -> Ble::advertisingFlagt {
-        uint8_t n;
-        
-        (([&]() -> juniper::unit {
-            n = BLE_GAP_ADV_FLAG_LE_LIMITED_DISC_MODE;
+namespace Arcada {
+    juniper::unit addDamage(int16_t x, int16_t y, int16_t w, int16_t h) {
+        return (([&]() -> juniper::unit {
+            damageAdd(x, y, w, h);
             return {};
         })());
-        return advertisingFlag(n);
-    })());
+    }
 }
 
-namespace Ble {
-    Ble::advertisingFlagt bleGapAdvFlagLeGeneralDiscMode = (([]() -> Ble::advertisingFlagt {
-        uint8_t n;
-        
-        (([&]() -> juniper::unit {
-            n = BLE_GAP_ADV_FLAG_LE_GENERAL_DISC_MODE;
+namespace Arcada {
+    juniper::unit clearDamage() {
+        return (([&]() -> juniper::unit {
+            damage.count = 0;
             return {};
         })());
-        return advertisingFlag(n);
-    })());
+    }
 }
 
-namespace Ble {
-    Ble::advertisingFlagt bleGapAdvFlagBrEdrNotSupported = (([]() -> Ble::advertisingFlagt {
-        uint8_t n;
-        
-        (([&]() -> juniper::unit {
-            n = BLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED;
-            return {};
+namespace Arcada {
+    bool blitDamage() {
+        return (([&]() -> bool {
+            bool guid348 = true;
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool ret = guid348;
+            
+            (([&]() -> juniper::unit {
+                ret = presentDamage();
+                return {};
+            })());
+            return ret;
         })());
-        return advertisingFlag(n);
-    })());
+    }
 }
 
-namespace Ble {
-    Ble::advertisingFlagt bleGapAdvFlagLeBrEdrController = (([]() -> Ble::advertisingFlagt {
-        uint8_t n;
-        
-        (([&]() -> juniper::unit {
-            n = BLE_GAP_ADV_FLAG_LE_BR_EDR_CONTROLLER;
-            return {};
+namespace Arcada {
+    bool beginPresent() {
+        return (([&]() -> bool {
+            bool guid373 = true;
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool ret = guid373;
+            
+            (([&]() -> juniper::unit {
+                ret = presentBegin(JUN_PRESENT_MODE);
+                return {};
+            })());
+            return ret;
         })());
-        return advertisingFlag(n);
-    })());
+    }
+}
+
+namespace Arcada {
+    uint32_t lastPresent() {
+        return (([&]() -> uint32_t {
+            uint32_t guid374 = ((uint32_t) 0);
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            uint32_t ret = guid374;
+            
+            (([&]() -> juniper::unit {
+                ret = presentFence();
+                return {};
+            })());
+            return ret;
+        })());
+    }
+}
+
+namespace Arcada {
+    bool isPresented(uint32_t fence) {
+        return (([&]() -> bool {
+            bool guid375 = true;
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool ret = guid375;
+            
+            (([&]() -> juniper::unit {
+                ret = presentDone(fence);
+                return {};
+            })());
+            return ret;
+        })());
+    }
+}
+
+namespace Arcada {
+    juniper::unit waitPresented(uint32_t fence) {
+        return (([&]() -> juniper::unit {
+            presentWait(fence);
+            return {};
+        })());
+    }
+}
+
+namespace Arcada {
+    bool createBackground() {
+        return (([&]() -> bool {
+            bool guid349 = true;
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool ret = guid349;
+            
+            (([&]() -> juniper::unit {
+                ret = backgroundCreate();
+                return {};
+            })());
+            return ret;
+        })());
+    }
+}
+
+namespace Arcada {
+    juniper::unit setBackgroundRow(int16_t y, uint16_t c) {
+        return (([&]() -> juniper::unit {
+            backgroundSetRow(y, c);
+            return {};
+        })());
+    }
+}
+
+namespace Arcada {
+    juniper::unit invalidateBackground() {
+        return (([&]() -> juniper::unit {
+            backgroundInvalidate();
+            return {};
+        })());
+    }
+}
+
+namespace Arcada {
+    juniper::unit restoreBackground() {
+        return (([&]() -> juniper::unit {
+            backgroundRestore();
+            return {};
+        })());
+    }
+}
+
+namespace Arcada {
+    bool hasBackground() {
+        return (([&]() -> bool {
+            bool guid350 = false;
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool ret = guid350;
+            
+            (([&]() -> juniper::unit {
+                ret = backgroundRows != NULL;
+                return {};
+            })());
+            return ret;
+        })());
+    }
+}
+
+namespace Arcada {
+    uint32_t backgroundInvalidatedAt() {
+        return (([&]() -> uint32_t {
+            uint32_t guid351 = ((uint32_t) 0);
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            uint32_t ret = guid351;
+            
+            (([&]() -> juniper::unit {
+                ret = backgroundInvalidated;
+                return {};
+            })());
+            return ret;
+        })());
+    }
+}
+
+namespace Arcada {
+    Prelude::sig<Io::pinState> readButtons(uint8_t buttonMask) {
+        return (([&]() -> Prelude::sig<Io::pinState> {
+            uint8_t pressedButtons;
+            
+            (([&]() -> juniper::unit {
+                pressedButtons = arcada.readButtons();
+                return {};
+            })());
+            return signal<Io::pinState>(just<Io::pinState>((((bool) (((uint8_t) (pressedButtons & buttonMask)) == ((uint8_t) 0))) ? 
+                Io::low()
+            :
+                Io::high())));
+        })());
+    }
+}
+
+namespace Arcada {
+    uint8_t JUN_ARCADA_BUTTONMASK_A = ((uint8_t) 1);
+}
+
+namespace Arcada {
+    uint8_t JUN_ARCADA_BUTTONMASK_B = ((uint8_t) 2);
+}
+
+namespace Arcada {
+    Prelude::sig<Io::pinState> readButtonA() {
+        return readButtons(JUN_ARCADA_BUTTONMASK_A);
+    }
+}
+
+namespace Arcada {
+    Prelude::sig<Io::pinState> readButtonB() {
+        return readButtons(JUN_ARCADA_BUTTONMASK_B);
+    }
+}
+
+namespace Ble {
+    Ble::advertisingFlagt bleGapAdvFlagLeLimitedDiscMode = (([]() -> Ble::advertisingFlagt {
+        uint8_t n;
+        
+        (([&]() -> juniper::unit {
+            n = BLE_GAP_ADV_FLAG_LE_LIMITED_DISC_MODE;
+            return {};
+        })());
+        return advertisingFlag(n);
+    })());
+}
+
+namespace Ble {
+    Ble::advertisingFlagt bleGapAdvFlagLeGeneralDiscMode = (([]() -> Ble::advertisingFlagt {
+        uint8_t n;
+        
+        (([&]() -> juniper::unit {
+            n = BLE_GAP_ADV_FLAG_LE_GENERAL_DISC_MODE;
+            return {};
+        })());
+        return advertisingFlag(n);
+    })());
+}
+
+namespace Ble {
+    Ble::advertisingFlagt bleGapAdvFlagBrEdrNotSupported = (([]() -> Ble::advertisingFlagt {
+        uint8_t n;
+        
+        (([&]() -> juniper::unit {
+            n = BLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED;
+            return {};
+        })());
+        return advertisingFlag(n);
+    })());
+}
+
+namespace Ble {
+    Ble::advertisingFlagt bleGapAdvFlagLeBrEdrController = (([]() -> Ble::advertisingFlagt {
+        uint8_t n;
+        
+        (([&]() -> juniper::unit {
+            n = BLE_GAP_ADV_FLAG_LE_BR_EDR_CONTROLLER;
+            return {};
+        })());
+        return advertisingFlag(n);
+    })());
 }
 
 namespace Ble {
@@ -10245,7 +10788,10 @@ namespace Ble {
                 uint16_t ret = guid233;
                 
                 (([&]() -> juniper::unit {
-                    ret = ((BLECharacteristic *) p)->write((void *) &x, sizeof(t));
+                    
+    uint8_t buf[juniper::binary::codec<t>::max_size];
+    ret = ((BLECharacteristic *) p)->write((void *) buf, juniper::binary::encode(x, buf));
+    
                     return {};
                 })());
                 return ret;
@@ -10269,7 +10815,15 @@ namespace Ble {
                 t4277 ret;
                 
                 (([&]() -> juniper::unit {
-                    ((BLECharacteristic *) p)->read((void *) &ret, sizeof(t));
+                    
+    uint8_t buf[juniper::binary::codec<t>::max_size];
+    uint16_t n = ((BLECharacteristic *) p)->read((void *) buf, sizeof(buf));
+    if (!juniper::binary::decode(buf, n, ret)) {
+        // Zero bytes are a valid encoding of every type
+        memset(buf, 0, sizeof(buf));
+        juniper::binary::decode(buf, sizeof(buf), ret);
+    }
+    
                     return {};
                 })());
                 return ret;
@@ -10550,10 +11104,15 @@ namespace CWatch {
 namespace CWatch {
     juniper::unit setup() {
         return (([&]() -> juniper::unit {
+            (([&]() -> juniper::unit {
+                juniper::stack::paint();
+                return {};
+            })());
             Arcada::arcadaBegin();
             Arcada::displayBegin();
             Arcada::setBacklight(((uint8_t) 255));
-            Arcada::createDoubleBuffer();
+            Arcada::createCanvas();
+            Arcada::beginPresent();
             Ble::bluefruitBegin();
             Ble::bluefruitPeriphSetConnInterval(((uint16_t) 9), ((uint16_t) 16));
             Ble::bluefruitSetTxPower(((int8_t) 4));
@@ -10574,6 +11133,10 @@ namespace CWatch {
     
                 return {};
             })());
+            (([&]() -> juniper::unit {
+                profileBegin();
+                return {};
+            })());
             Ble::bluefruitAdvertisingAddFlags(Ble::bleGapAdvFlagsLeOnlyGeneralDiscMode);
             Ble::bluefruitAdvertisingAddTxPower();
             Ble::bluefruitAdvertisingAddAppearance(Ble::appearanceGenericWatch);
@@ -10584,7 +11147,12 @@ namespace CWatch {
             Ble::bluefruitAdvertisingSetFastTimeout(((uint16_t) 30));
             Ble::bluefruitAdvertisingStart(((uint16_t) 0));
             Io::setPinMode(whiteLED, Io::output());
-            return Io::digWrite(whiteLED, Io::low());
+            Io::digWrite(whiteLED, Io::low());
+            Gfx::setVerticalGradientBackground(pink, purpleBlue);
+            return (([&]() -> juniper::unit {
+                juniper::stack::sample();
+                return {};
+            })());
         })());
     }
 }
@@ -11339,7 +11907,78 @@ namespace Gfx {
                 uint16_t hret = guid289;
                 
                 (([&]() -> juniper::unit {
-                    arcada.getCanvas()->getTextBounds((const char *) &cl.data[0], x, y, &xret, &yret, &wret, &hret);
+                    textBoundsAt((const char *) &cl.data[0], x, y, &xret, &yret, &wret, &hret);
+                    return {};
+                })());
+                return (juniper::tuple4<int16_t,int16_t,uint16_t,uint16_t>{xret, yret, wret, hret});
+            })());
+        })());
+    }
+}
+
+namespace Gfx {
+    template<int c260>
+    juniper::tuple4<int16_t, int16_t, uint16_t, uint16_t> measure(Gfx::font f, int16_t x, int16_t y, juniper::records::recordt_0<juniper::array<uint8_t, (1)+(c260)>, uint32_t> cl) {
+        return (([&]() -> juniper::tuple4<int16_t, int16_t, uint16_t, uint16_t> {
+            constexpr int32_t n = c260;
+            return (([&]() -> juniper::tuple4<int16_t, int16_t, uint16_t, uint16_t> {
+                uint8_t guid381 = (([&]() -> uint8_t {
+                    Gfx::font guid382 = f;
+                    return (((bool) (((bool) ((guid382).id() == ((uint8_t) 0))) && true)) ? 
+                        (([&]() -> uint8_t {
+                            return ((uint8_t) 0);
+                        })())
+                    :
+                        (((bool) (((bool) ((guid382).id() == ((uint8_t) 1))) && true)) ? 
+                            (([&]() -> uint8_t {
+                                return ((uint8_t) 1);
+                            })())
+                        :
+                            (((bool) (((bool) ((guid382).id() == ((uint8_t) 2))) && true)) ? 
+                                (([&]() -> uint8_t {
+                                    return ((uint8_t) 2);
+                                })())
+                            :
+                                juniper::quit<uint8_t>())));
+                })());
+                if (!(true)) {
+                    juniper::quit<juniper::unit>();
+                }
+                uint8_t index = guid381;
+                
+                int16_t guid383 = ((int16_t) 0);
+                if (!(true)) {
+                    juniper::quit<juniper::unit>();
+                }
+                int16_t xret = guid383;
+                
+                int16_t guid384 = ((int16_t) 0);
+                if (!(true)) {
+                    juniper::quit<juniper::unit>();
+                }
+                int16_t yret = guid384;
+                
+                uint16_t guid385 = ((uint16_t) 0);
+                if (!(true)) {
+                    juniper::quit<juniper::unit>();
+                }
+                uint16_t wret = guid385;
+                
+                uint16_t guid386 = ((uint16_t) 0);
+                if (!(true)) {
+                    juniper::quit<juniper::unit>();
+                }
+                uint16_t hret = guid386;
+                
+                (([&]() -> juniper::unit {
+                    
+    const GFXfont *fonts[] = { NULL, &FreeSans9pt7b, &FreeSans24pt7b };
+    textBounds b = textMeasure(fonts[index], (const char *) &cl.data[0], x, y);
+    xret = b.x;
+    yret = b.y;
+    wret = b.w;
+    hret = b.h;
+    
                     return {};
                 })());
                 return (juniper::tuple4<int16_t,int16_t,uint16_t,uint16_t>{xret, yret, wret, hret});
@@ -11354,7 +11993,7 @@ namespace Gfx {
         return (([&]() -> juniper::unit {
             constexpr int32_t n = c230;
             return (([&]() -> juniper::unit {
-                arcada.getCanvas()->print((char *) &cl.data[0]);
+                printCached((const char *) &cl.data[0]);
                 return {};
             })());
         })());
@@ -11364,7 +12003,7 @@ namespace Gfx {
 namespace Gfx {
     juniper::unit setCursor(int16_t x, int16_t y) {
         return (([&]() -> juniper::unit {
-            arcada.getCanvas()->setCursor(x, y);
+            canvasLayout()->setCursor(x, y);
             return {};
         })());
     }
@@ -11377,7 +12016,7 @@ namespace Gfx {
             return (((bool) (((bool) ((guid290).id() == ((uint8_t) 0))) && true)) ? 
                 (([&]() -> juniper::unit {
                     return (([&]() -> juniper::unit {
-                        arcada.getCanvas()->setFont();
+                        textSetFont(NULL);
                         return {};
                     })());
                 })())
@@ -11385,7 +12024,7 @@ namespace Gfx {
                 (((bool) (((bool) ((guid290).id() == ((uint8_t) 1))) && true)) ? 
                     (([&]() -> juniper::unit {
                         return (([&]() -> juniper::unit {
-                            arcada.getCanvas()->setFont(&FreeSans9pt7b);
+                            textSetFont(&FreeSans9pt7b);
                             return {};
                         })());
                     })())
@@ -11393,7 +12032,7 @@ namespace Gfx {
                     (((bool) (((bool) ((guid290).id() == ((uint8_t) 2))) && true)) ? 
                         (([&]() -> juniper::unit {
                             return (([&]() -> juniper::unit {
-                                arcada.getCanvas()->setFont(&FreeSans24pt7b);
+                                textSetFont(&FreeSans24pt7b);
                                 return {};
                             })());
                         })())
@@ -11413,7 +12052,7 @@ namespace Gfx {
             uint16_t cPrime = guid291;
             
             return (([&]() -> juniper::unit {
-                arcada.getCanvas()->setTextColor(cPrime);
+                textSetColor(cPrime);
                 return {};
             })());
         })());
@@ -11423,7 +12062,7 @@ namespace Gfx {
 namespace Gfx {
     juniper::unit setTextSize(uint8_t size) {
         return (([&]() -> juniper::unit {
-            arcada.getCanvas()->setTextSize(size);
+            textSetSize(size);
             return {};
         })());
     }
@@ -11574,7 +12213,28 @@ namespace Gfx {
             uint16_t c2 = guid309;
             
             return (([&]() -> juniper::unit {
-                arcada.getCanvas()->drawCircle(x0, y0, r, c2);
+                
+    opDrawCircle(x0, y0, r, c2);
+    
+                return {};
+            })());
+        })());
+    }
+}
+
+namespace Gfx {
+    juniper::unit fillRect(int16_t x, int16_t y, int16_t w, int16_t h, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c) {
+        return (([&]() -> juniper::unit {
+            uint16_t guid367 = Color::rgbToRgb565(c);
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            uint16_t c2 = guid367;
+            
+            return (([&]() -> juniper::unit {
+                
+    opFillRect(x, y, w, h, c2);
+    
                 return {};
             })());
         })());
@@ -11591,7 +12251,9 @@ namespace Gfx {
             uint16_t c2 = guid310;
             
             return (([&]() -> juniper::unit {
-                arcada.getCanvas()->fillCircle(x0, y0, r, c2);
+                
+    opFillCircle(x0, y0, r, c2);
+    
                 return {};
             })());
         })());
@@ -11640,141 +12302,132 @@ namespace CWatch {
 namespace Gfx {
     juniper::unit drawFastHLine565(int16_t x, int16_t y, int16_t w, uint16_t c) {
         return (([&]() -> juniper::unit {
-            arcada.getCanvas()->drawFastHLine(x, y, w, c);
+            
+    opHLine(x, y, w, c);
+    
             return {};
         })());
     }
 }
 
 namespace Gfx {
-    juniper::unit drawVerticalGradient(int16_t x0i, int16_t y0i, int16_t w, int16_t h, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c1, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c2) {
+    template<int c256>
+    juniper::unit drawGradient(int16_t x, int16_t y, int16_t w, int16_t h, Gfx::gradientDirection dir, juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, c256>, uint32_t> stops, bool dither) {
         return (([&]() -> juniper::unit {
-            int16_t guid315 = toInt16<uint16_t>(Arcada::displayWidth());
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            int16_t dispW = guid315;
-            
-            int16_t guid316 = toInt16<uint16_t>(Arcada::displayHeight());
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            int16_t dispH = guid316;
-            
-            int16_t guid317 = Math::clamp<int16_t>(x0i, ((int16_t) 0), ((int16_t) (dispW - ((int16_t) 1))));
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            int16_t x0 = guid317;
-            
-            int16_t guid318 = Math::clamp<int16_t>(y0i, ((int16_t) 0), ((int16_t) (dispH - ((int16_t) 1))));
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            int16_t y0 = guid318;
-            
-            int16_t guid319 = ((int16_t) (y0i + h));
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            int16_t ymax = guid319;
-            
-            int16_t guid320 = Math::clamp<int16_t>(ymax, ((int16_t) 0), dispH);
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            int16_t y1 = guid320;
-            
-            juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> guid321 = c1;
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            uint8_t b1 = (guid321).b;
-            uint8_t g1 = (guid321).g;
-            uint8_t r1 = (guid321).r;
-            
-            juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> guid322 = c2;
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            uint8_t b2 = (guid322).b;
-            uint8_t g2 = (guid322).g;
-            uint8_t r2 = (guid322).r;
-            
-            float guid323 = toFloat<uint8_t>(r1);
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            float r1f = guid323;
-            
-            float guid324 = toFloat<uint8_t>(g1);
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            float g1f = guid324;
-            
-            float guid325 = toFloat<uint8_t>(b1);
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            float b1f = guid325;
-            
-            float guid326 = toFloat<uint8_t>(r2);
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            float r2f = guid326;
-            
-            float guid327 = toFloat<uint8_t>(g2);
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            float g2f = guid327;
-            
-            float guid328 = toFloat<uint8_t>(b2);
-            if (!(true)) {
-                juniper::quit<juniper::unit>();
-            }
-            float b2f = guid328;
-            
+            constexpr int32_t n = c256;
             return (([&]() -> juniper::unit {
-                int16_t guid329 = y0;
-                int16_t guid330 = y1;
-                for (int16_t y = guid329; y < guid330; y++) {
-                    (([&]() -> juniper::unit {
-                        float guid331 = ((float) (toFloat<int16_t>(((int16_t) (ymax - y))) / toFloat<int16_t>(h)));
-                        if (!(true)) {
-                            juniper::quit<juniper::unit>();
-                        }
-                        float weight1 = guid331;
-                        
-                        float guid332 = ((float) (1.0f - weight1));
-                        if (!(true)) {
-                            juniper::quit<juniper::unit>();
-                        }
-                        float weight2 = guid332;
-                        
-                        juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> guid333 = (([&]() -> juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>{
-                            juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> guid334;
-                            guid334.r = toUInt8<float>(((float) (((float) (r1f * weight1)) + ((float) (r2f * weight2)))));
-                            guid334.g = toUInt8<float>(((float) (((float) (g1f * weight1)) + ((float) (g2f * weight2)))));
-                            guid334.b = toUInt8<float>(((float) (((float) (b1f * weight1)) + ((float) (g2f * weight2)))));
-                            return guid334;
-                        })());
-                        if (!(true)) {
-                            juniper::quit<juniper::unit>();
-                        }
-                        juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> gradColor = guid333;
-                        
-                        uint16_t guid335 = Color::rgbToRgb565(gradColor);
-                        if (!(true)) {
-                            juniper::quit<juniper::unit>();
-                        }
-                        uint16_t gradColor565 = guid335;
-                        
-                        return drawFastHLine565(x0, y, w, gradColor565);
-                    })());
+                uint8_t guid368 = (([&]() -> uint8_t {
+                    Gfx::gradientDirection guid369 = dir;
+                    return (((bool) (((bool) ((guid369).id() == ((uint8_t) 0))) && true)) ? 
+                        (([&]() -> uint8_t {
+                            return ((uint8_t) 0);
+                        })())
+                    :
+                        (((bool) (((bool) ((guid369).id() == ((uint8_t) 1))) && true)) ? 
+                            (([&]() -> uint8_t {
+                                return ((uint8_t) 1);
+                            })())
+                        :
+                            (((bool) (((bool) ((guid369).id() == ((uint8_t) 2))) && true)) ? 
+                                (([&]() -> uint8_t {
+                                    return ((uint8_t) 2);
+                                })())
+                            :
+                                juniper::quit<uint8_t>())));
+                })());
+                if (!(true)) {
+                    juniper::quit<juniper::unit>();
                 }
+                uint8_t axis = guid368;
+                
+                return (([&]() -> juniper::unit {
+                    
+    gradient gr;
+    gradientEvenStops(gr, &stops.data[0], stops.length, dither);
+    opLinear(gr, axis, x, y, w, h);
+    
+                    return {};
+                })());
+            })());
+        })());
+    }
+}
+
+namespace Gfx {
+    template<int c258>
+    juniper::unit drawRadialGradient(int16_t x, int16_t y, int16_t w, int16_t h, int16_t cx, int16_t cy, int16_t r, juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, c258>, uint32_t> stops, bool dither) {
+        return (([&]() -> juniper::unit {
+            constexpr int32_t n = c258;
+            return (([&]() -> juniper::unit {
+                
+    gradient gr;
+    gradientEvenStops(gr, &stops.data[0], stops.length, dither);
+    opRadial(gr, x, y, w, h, cx, cy, r);
+    
+                return {};
+            })());
+        })());
+    }
+}
+
+namespace Gfx {
+    juniper::unit drawVerticalGradient(int16_t x0, int16_t y0, int16_t w, int16_t h, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c1, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c2) {
+        return (([&]() -> juniper::unit {
+            return Gfx::drawGradient<2>(x0, y0, w, h, Gfx::gradientVertical(), (([&]() -> juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, 2>, uint32_t>{
+                juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, 2>, uint32_t> guid370;
+                guid370.data = (juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, 2> { {c1, c2} });
+                guid370.length = ((uint32_t) 2);
+                return guid370;
+            })()), false);
+        })());
+    }
+}
+
+namespace Gfx {
+    template<int c257>
+    juniper::unit setGradientBackground(juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, c257>, uint32_t> stops) {
+        return (([&]() -> juniper::unit {
+            constexpr int32_t n = c257;
+            return (([&]() -> juniper::unit {
+                Arcada::createBackground();
+                (([&]() -> juniper::unit {
+                    
+    gradient gr;
+    gradientEvenStops(gr, &stops.data[0], stops.length, false);
+    gradientBackground(gr);
+    
+                    return {};
+                })());
+                return Arcada::invalidateBackground();
+            })());
+        })());
+    }
+}
+
+namespace Gfx {
+    juniper::unit setVerticalGradientBackground(juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c1, juniper::records::recordt_3<uint8_t, uint8_t, uint8_t> c2) {
+        return (([&]() -> juniper::unit {
+            return Gfx::setGradientBackground<2>((([&]() -> juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, 2>, uint32_t>{
+                juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, 2>, uint32_t> guid371;
+                guid371.data = (juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, 2> { {c1, c2} });
+                guid371.length = ((uint32_t) 2);
+                return guid371;
+            })()));
+        })());
+    }
+}
+
+namespace Gfx {
+    template<int c259>
+    juniper::unit paletteFromGradient(juniper::records::recordt_0<juniper::array<juniper::records::recordt_3<uint8_t, uint8_t, uint8_t>, c259>, uint32_t> stops, uint16_t n) {
+        return (([&]() -> juniper::unit {
+            constexpr int32_t m = c259;
+            return (([&]() -> juniper::unit {
+                
+    gradient gr;
+    gradientEvenStops(gr, &stops.data[0], stops.length, false);
+    paletteAddGradient(gr, n);
+    
                 return {};
             })());
         })());
@@ -11784,8 +12437,24 @@ namespace Gfx {
 namespace CWatch {
     bool loop() {
         return (([&]() -> bool {
-            Gfx::drawVerticalGradient(((int16_t) 0), ((int16_t) 0), toInt16<uint16_t>(Arcada::displayWidth()), toInt16<uint16_t>(Arcada::displayHeight()), pink, purpleBlue);
+            (([&]() -> juniper::unit {
+                juniper::memory::frame_begin();
+                return {};
+            })());
+            (([&]() -> juniper::unit {
+                profileEnter(phaseBackground);
+                return {};
+            })());
+            Arcada::restoreBackground();
+            (([&]() -> juniper::unit {
+                profileEnter(phaseBluetooth);
+                return {};
+            })());
             processBluetoothUpdates();
+            (([&]() -> juniper::unit {
+                profileEnter(phaseSignals);
+                return {};
+            })());
             Signal::foldP<uint32_t, void, juniper::records::recordt_9<uint8_t, CWatch::dayOfWeek, uint8_t, uint8_t, CWatch::month, uint8_t, uint32_t>>(juniper::function<void, juniper::records::recordt_9<uint8_t, CWatch::dayOfWeek, uint8_t, uint8_t, CWatch::month, uint8_t, uint32_t>(uint32_t,juniper::records::recordt_9<uint8_t, CWatch::dayOfWeek, uint8_t, uint8_t, CWatch::month, uint8_t, uint32_t>)>([](uint32_t t, juniper::records::recordt_9<uint8_t, CWatch::dayOfWeek, uint8_t, uint8_t, CWatch::month, uint8_t, uint32_t> dt) -> juniper::records::recordt_9<uint8_t, CWatch::dayOfWeek, uint8_t, uint8_t, CWatch::month, uint8_t, uint32_t> { 
                 return secondTick(dt);
              }), clockState, Time::every(((uint32_t) 1000), clockTickerState));
@@ -11811,6 +12480,10 @@ namespace CWatch {
                             juniper::quit<CWatch::watchModeT>()));
                 })());
              }), watchMode, Io::risingEdge(buttonBSig, modeButtonBState));
+            (([&]() -> juniper::unit {
+                profileEnter(phaseDraw);
+                return {};
+            })());
             (([&]() -> juniper::unit {
                 CWatch::watchModeT guid338 = watchMode;
                 return (((bool) (((bool) ((guid338).id() == ((uint8_t) 0))) && true)) ? 
@@ -11864,7 +12537,25 @@ namespace CWatch {
                     :
                         juniper::quit<juniper::unit>()));
             })());
-            return Arcada::blitDoubleBuffer();
+            (([&]() -> juniper::unit {
+                profileEnter(phaseBlit);
+                return {};
+            })());
+            bool guid372 = Arcada::blitDamage();
+            if (!(true)) {
+                juniper::quit<juniper::unit>();
+            }
+            bool sent = guid372;
+            
+            (([&]() -> juniper::unit {
+                profileFrameEnd();
+                return {};
+            })());
+            (([&]() -> juniper::unit {
+                juniper::memory::frame_end();
+                return {};
+            })());
+            return sent;
         })());
     }
 }
@@ -11879,7 +12570,9 @@ namespace Gfx {
             uint16_t cPrime = guid342;
             
             return (([&]() -> juniper::unit {
-                arcada.getCanvas()->fillScreen(cPrime);
+                
+    opFillRect(0, 0, canvasLayout()->width(), canvasLayout()->height(), cPrime);
+    
                 return {};
             })());
         })());
@@ -11896,7 +12589,9 @@ namespace Gfx {
             uint16_t cPrime = guid343;
             
             return (([&]() -> juniper::unit {
-                arcada.getCanvas()->drawPixel(x, y, cPrime);
+                
+    opPixel(x, y, cPrime);
+    
                 return {};
             })());
         })());
@@ -11906,7 +12601,9 @@ namespace Gfx {
 namespace Gfx {
     juniper::unit drawPixel565(uint16_t x, uint16_t y, uint16_t c) {
         return (([&]() -> juniper::unit {
-            arcada.getCanvas()->drawPixel(x, y, c);
+            
+    opPixel(x, y, c);
+    
             return {};
         })());
     }
@@ -11915,7 +12612,7 @@ namespace Gfx {
 namespace Gfx {
     juniper::unit printString(const char * s) {
         return (([&]() -> juniper::unit {
-            arcada.getCanvas()->print(s);
+            printCached(s);
             return {};
         })());
     }
@@ -11973,7 +12670,7 @@ namespace Gfx {
 namespace Gfx {
     juniper::unit setTextWrap(bool wrap) {
         return (([&]() -> juniper::unit {
-            arcada.getCanvas()->setTextWrap(wrap);
+            textSetWrap(wrap);
             return {};
         })());
     }
@@ -0,0 +1,45 @@
+// Device runner for the runtime microbenchmark suite in
+// host/bench_cases.h. It runs the same cases as host/bench_suite.cpp,
+// timed in CPU cycles with the DWT counter juniper::profile reads, and
+// prints the JSON to serial at 115200 baud once the port is open. Run
+// host/build.sh first: it copies the generated sketch into this folder
+// as cwatch_main.h, along with the headers it includes and
+// bench_cases.h.
+#include <Arduino.h>
+#include "Adafruit_Arcada.h"
+#include <bluefruit.h>
+#include <Adafruit_GFX.h>
+
+// For juniper::profile's cycle counter
+#define JUN_PROFILE
+
+// The generated sketch brings its own setup() and loop(), which are
+// renamed out of the way of this runner's. The libraries it includes are
+// included above, so that the renaming only reaches the sketch.
+#define setup cwatchSetup
+#define loop cwatchLoop
+#include "cwatch_main.h"
+#undef setup
+#undef loop
+
+#include "bench_cases.h"
+
+static uint32_t nowCycles() {
+    return juniper::profile::now();
+}
+
+static void emit(const char *line) {
+    Serial.print(line);
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        delay(10);
+    }
+    juniper::profile::start_clock();
+    bench::runAll(nowCycles, "cycles", "", emit);
+}
+
+void loop() {
+}
@@ -0,0 +1,106 @@
+#ifndef ARCADA_BACKGROUND_H
+#define ARCADA_BACKGROUND_H
+
+#include <stdlib.h>
+#include "arcada_present.h"
+#include "arcada_span.h"
+
+namespace arcada_gfx
+{
+    // The background layer is a retained table with one RGB565 colour per
+    // canvas row, which is all a vertical gradient needs and costs two bytes
+    // per row instead of a second framebuffer. Foreground drawing is tracked
+    // in backgroundOverdrawn so the next restore only rewrites the rows that
+    // were actually covered.
+    uint16_t *backgroundRows = NULL;
+    int16_t backgroundHeight = 0;
+    bool backgroundPending = false;
+    uint32_t backgroundInvalidated = 0;
+    damageList backgroundOverdrawn;
+
+    // From arcada_list.h, which includes this header for the table above
+    inline void listForget();
+    inline bool listRestore(const damageRect& r);
+
+    inline void damageAdd(int32_t x, int32_t y, int32_t w, int32_t h) {
+        presentPump();
+
+        damageRect r;
+        if (!damageClip(x, y, w, h, r)) {
+            return;
+        }
+
+        damageListAdd(damage, r);
+        if (backgroundRows != NULL) {
+            damageListAdd(backgroundOverdrawn, r);
+        }
+    }
+
+    inline bool backgroundCreate() {
+        Adafruit_GFX *canvas = canvasLayout();
+        if (canvas == NULL) {
+            return false;
+        }
+        if (backgroundRows == NULL) {
+            backgroundRows = (uint16_t *) calloc(canvas->height(), sizeof(uint16_t));
+            backgroundHeight = backgroundRows != NULL ? canvas->height() : 0;
+        }
+        return backgroundRows != NULL;
+    }
+
+    // Rows outside the table, or a table that was never created, are ignored
+    inline void backgroundSetRow(int16_t y, uint16_t c) {
+        if (backgroundRows == NULL || y < 0 || y >= backgroundHeight) {
+            return;
+        }
+        backgroundRows[y] = c;
+    }
+
+    inline void backgroundInvalidate() {
+        backgroundPending = true;
+        backgroundInvalidated = millis();
+    }
+
+    inline void backgroundRestoreRect(const damageRect& r) {
+        if (indexedCanvas != NULL) {
+            for (int16_t y = r.y0; y < r.y1; y++) {
+                indexedCanvas->fillSpan(r.x0, y, r.x1 - r.x0, indexedCanvas->nearestIndex(backgroundRows[y]));
+            }
+        } else if (!bandMode && !listRestore(r)) {
+            // Bands start out as background when they are rendered
+            GFXcanvas16 *canvas = arcada.getCanvas();
+            uint16_t *buffer = canvas->getBuffer();
+            int16_t stride = canvas->width();
+            for (int16_t y = r.y0; y < r.y1; y++) {
+                canvasFillSpan(&buffer[(int32_t) y * stride + r.x0], r.x1 - r.x0, backgroundRows[y]);
+            }
+        }
+        damageListAdd(damage, r);
+    }
+
+    // Puts the background back everywhere it was drawn over since the last
+    // restore, or over the whole canvas after an invalidation.
+    inline void backgroundRestore() {
+        presentPump();
+        if (backgroundRows == NULL) {
+            return;
+        }
+
+        if (backgroundPending) {
+            damageRect all;
+            if (damageClip(0, 0, INT16_MAX, INT16_MAX, all)) {
+                backgroundRestoreRect(all);
+            }
+            backgroundPending = false;
+            // Everything drawn before is gone, retained or not
+            listForget();
+        } else {
+            for (uint8_t i = 0; i < backgroundOverdrawn.count; i++) {
+                backgroundRestoreRect(backgroundOverdrawn.rects[i]);
+            }
+        }
+        backgroundOverdrawn.count = 0;
+    }
+}
+
+#endif
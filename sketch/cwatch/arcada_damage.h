@@ -0,0 +1,160 @@
+#ifndef ARCADA_DAMAGE_H
+#define ARCADA_DAMAGE_H
+
+#include <stdint.h>
+#include "arcada_palette.h"
+
+namespace arcada_gfx
+{
+    // Regions of the canvas written since the last damage blit, stored as
+    // half-open rectangles. Rectangles that overlap, or whose union costs no
+    // more pixels than the two apart, are merged as they are added. Once the
+    // list is full a new region is folded into whichever rectangle grows the
+    // least, so the list always covers everything that was drawn.
+#ifndef JUN_DAMAGE_MAX_RECTS
+#define JUN_DAMAGE_MAX_RECTS 8
+#endif
+
+    struct damageRect {
+        int16_t x0;
+        int16_t y0;
+        int16_t x1;
+        int16_t y1;
+    };
+
+    struct damageList {
+        damageRect rects[JUN_DAMAGE_MAX_RECTS];
+        uint8_t count;
+    };
+
+    damageList damage;
+
+    inline int32_t damageArea(const damageRect& r) {
+        return (int32_t) (r.x1 - r.x0) * (int32_t) (r.y1 - r.y0);
+    }
+
+    inline damageRect damageUnion(const damageRect& a, const damageRect& b) {
+        damageRect u;
+        u.x0 = a.x0 < b.x0 ? a.x0 : b.x0;
+        u.y0 = a.y0 < b.y0 ? a.y0 : b.y0;
+        u.x1 = a.x1 > b.x1 ? a.x1 : b.x1;
+        u.y1 = a.y1 > b.y1 ? a.y1 : b.y1;
+        return u;
+    }
+
+    inline bool damageShouldMerge(const damageRect& a, const damageRect& b) {
+        bool overlaps = a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+        return overlaps || damageArea(damageUnion(a, b)) <= damageArea(a) + damageArea(b);
+    }
+
+    inline void damageListAdd(damageList& list, damageRect r) {
+        for (;;) {
+            uint8_t target = list.count;
+            for (uint8_t i = 0; i < list.count; i++) {
+                if (damageShouldMerge(list.rects[i], r)) {
+                    target = i;
+                    break;
+                }
+            }
+
+            if (target == list.count && list.count == JUN_DAMAGE_MAX_RECTS) {
+                int32_t bestGrowth = INT32_MAX;
+                for (uint8_t i = 0; i < list.count; i++) {
+                    int32_t growth = damageArea(damageUnion(list.rects[i], r)) - damageArea(list.rects[i]);
+                    if (growth < bestGrowth) {
+                        bestGrowth = growth;
+                        target = i;
+                    }
+                }
+            }
+
+            if (target == list.count) {
+                break;
+            }
+
+            // The merged rectangle may now reach others, so take it out and retry
+            r = damageUnion(list.rects[target], r);
+            list.rects[target] = list.rects[--list.count];
+        }
+
+        list.rects[list.count++] = r;
+    }
+
+    // Clips a rectangle to the canvas, returning false if nothing is left
+    inline bool damageClip(int32_t x, int32_t y, int32_t w, int32_t h, damageRect& r) {
+        Adafruit_GFX *canvas = canvasLayout();
+        if (canvas == NULL || w <= 0 || h <= 0) {
+            return false;
+        }
+
+        int32_t x1 = x + w;
+        int32_t y1 = y + h;
+        r.x0 = (int16_t) (x < 0 ? 0 : x);
+        r.y0 = (int16_t) (y < 0 ? 0 : y);
+        r.x1 = (int16_t) (x1 > canvas->width() ? canvas->width() : x1);
+        r.y1 = (int16_t) (y1 > canvas->height() ? canvas->height() : y1);
+        return r.x0 < r.x1 && r.y0 < r.y1;
+    }
+
+    // damageBlit for an indexed canvas, which has to be expanded to RGB565
+    // on the way out. Expands a short run of pixels at a time on the stack.
+    inline bool damageBlitIndexed() {
+        uint16_t line[64];
+        Adafruit_SPITFT *tft = arcada.display;
+
+        tft->startWrite();
+        for (uint8_t i = 0; i < damage.count; i++) {
+            const damageRect& r = damage.rects[i];
+            tft->setAddrWindow(r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0);
+            for (int16_t y = r.y0; y < r.y1; y++) {
+                for (int16_t x = r.x0; x < r.x1; x += 64) {
+                    int16_t n = r.x1 - x < 64 ? r.x1 - x : 64;
+                    indexedCanvas->expand(x, y, n, line);
+                    tft->writePixels(line, n, true, false);
+                }
+            }
+        }
+        tft->endWrite();
+
+        damage.count = 0;
+        return true;
+    }
+
+    // Sends only the damaged rectangles to the display, one address window
+    // per rectangle, then empties the damage list.
+    inline bool damageBlit() {
+        GFXcanvas16 *canvas = arcada.getCanvas();
+        if (indexedCanvas != NULL) {
+            return damageBlitIndexed();
+        }
+        if (canvas == NULL) {
+            return false;
+        }
+
+        uint16_t *buffer = canvas->getBuffer();
+        int16_t stride = canvas->width();
+        Adafruit_SPITFT *tft = arcada.display;
+
+        tft->startWrite();
+        for (uint8_t i = 0; i < damage.count; i++) {
+            const damageRect& r = damage.rects[i];
+            int16_t w = r.x1 - r.x0;
+            int16_t h = r.y1 - r.y0;
+            tft->setAddrWindow(r.x0, r.y0, w, h);
+            if (w == stride) {
+                // Full-width rows are contiguous in the canvas
+                tft->writePixels(&buffer[(int32_t) r.y0 * stride], (uint32_t) w * h, true, false);
+            } else {
+                for (int16_t y = r.y0; y < r.y1; y++) {
+                    tft->writePixels(&buffer[(int32_t) y * stride + r.x0], w, true, false);
+                }
+            }
+        }
+        tft->endWrite();
+
+        damage.count = 0;
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,464 @@
+#ifndef GFX_GRADIENT_H
+#define GFX_GRADIENT_H
+
+#include <string.h>
+#include "arcada_background.h"
+#include "gfx_kernels.h"
+
+namespace arcada_gfx
+{
+    // Gradients. Colours are stepped incrementally along the gradient in
+    // 16.16 fixed point, already scaled to the RGB565 channel ranges, so the
+    // only divisions happen once per colour stop when a segment starts. A
+    // colour is packed into one word before conversion to RGB565 (see
+    // gradientPacked) and receives its rounding in a single add: half an LSB
+    // normally, or a 4x4 Bayer threshold when dithering, which makes the
+    // dithered paths exactly as cheap per pixel as the plain ones.
+#ifndef JUN_GRADIENT_MAX_STOPS
+#define JUN_GRADIENT_MAX_STOPS 8
+#endif
+
+    // The widest canvas a gradient can be drawn into through a scratch row,
+    // and the widest and tallest clipped area a radial gradient can fill.
+    // Both work in static buffers sized from it rather than allocating per
+    // draw; a canvas or area larger than that is left undrawn.
+#ifndef JUN_GRADIENT_MAX_WIDTH
+#define JUN_GRADIENT_MAX_WIDTH 240
+#endif
+
+    // Ring colours a radial gradient can need over an area no wider or taller
+    // than JUN_GRADIENT_MAX_WIDTH: its farthest pixel is at most the area's
+    // width plus its height further from the centre than its nearest
+#define GRADIENT_MAX_RINGS (2 * JUN_GRADIENT_MAX_WIDTH + 1)
+
+    uint16_t gradientScratch[JUN_GRADIENT_MAX_WIDTH];
+    uint32_t gradientRings[GRADIENT_MAX_RINGS];
+
+    // Stop positions run from 0 at the start of a gradient to
+    // GRADIENT_POS_ONE at its end
+#define GRADIENT_POS_ONE 4096
+
+    struct gradientStop {
+        uint16_t pos;
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+    };
+
+    // Stops must be sorted by position
+    struct gradient {
+        gradientStop stops[JUN_GRADIENT_MAX_STOPS];
+        uint8_t count;
+        bool dither;
+    };
+
+    enum gradientAxis {
+        gradientAlongY,
+        gradientAlongX,
+        gradientAlongDiagonal
+    };
+
+    // Spreads colours (anything with r, g and b fields) evenly over a
+    // gradient. Colours past JUN_GRADIENT_MAX_STOPS are dropped.
+    template<typename Rgb>
+    void gradientEvenStops(gradient& gr, const Rgb *colors, uint32_t count, bool dither) {
+        // Display list entries are compared byte for byte, padding included
+        memset(&gr, 0, sizeof(gr));
+        if (count > JUN_GRADIENT_MAX_STOPS) {
+            count = JUN_GRADIENT_MAX_STOPS;
+        }
+        gr.count = count;
+        gr.dither = dither;
+        for (uint32_t i = 0; i < count; i++) {
+            gr.stops[i].pos = count > 1 ? i * GRADIENT_POS_ONE / (count - 1) : 0;
+            gr.stops[i].r = colors[i].r;
+            gr.stops[i].g = colors[i].g;
+            gr.stops[i].b = colors[i].b;
+        }
+    }
+
+    // A packed colour holds red in bits 21-31 (5.6 fixed point), green in bits
+    // 10-20 (6.5) and blue in bits 0-9 (5.5). The channel maxima plus the
+    // largest bias still fit their fields, so adding a bias never carries
+    // from one channel into the next.
+#define GRADIENT_BIAS(k) (((uint32_t) (4 * (k) + 2) << 21) | ((uint32_t) (2 * (k) + 1) << 10) | (uint32_t) (2 * (k) + 1))
+
+    const uint32_t gradientRound = ((uint32_t) 32 << 21) | ((uint32_t) 16 << 10) | (uint32_t) 16;
+
+    const uint32_t gradientBayer[4][4] = {
+        { GRADIENT_BIAS(0), GRADIENT_BIAS(8), GRADIENT_BIAS(2), GRADIENT_BIAS(10) },
+        { GRADIENT_BIAS(12), GRADIENT_BIAS(4), GRADIENT_BIAS(14), GRADIENT_BIAS(6) },
+        { GRADIENT_BIAS(3), GRADIENT_BIAS(11), GRADIENT_BIAS(1), GRADIENT_BIAS(9) },
+        { GRADIENT_BIAS(15), GRADIENT_BIAS(7), GRADIENT_BIAS(13), GRADIENT_BIAS(5) }
+    };
+
+    inline uint16_t gradient565(uint32_t packed) {
+        return ((packed >> 16) & 0xF800) | ((packed >> 10) & 0x07E0) | ((packed >> 5) & 0x001F);
+    }
+
+    // The biases for the four columns of canvas row y, indexed by x & 3.
+    // Dither thresholds follow canvas coordinates so neighbouring gradients
+    // tile without seams.
+    inline void gradientBias(const gradient& gr, int32_t y, uint32_t bias[4]) {
+        for (int32_t k = 0; k < 4; k++) {
+            bias[k] = gr.dither ? gradientBayer[y & 3][k] : gradientRound;
+        }
+    }
+
+    // Walks a gradient one step at a time. The gradient spans steps 0 to
+    // last; before the first stop and after the final one it is flat.
+    struct gradientDda {
+        const gradient *gr;
+        int32_t last;
+        int32_t i;
+        // First step past the current segment
+        int32_t end;
+        // Current colour and per-step deltas, 16.16 in RGB565 channel units
+        int32_t r;
+        int32_t g;
+        int32_t b;
+        int32_t dr;
+        int32_t dg;
+        int32_t db;
+    };
+
+    inline int32_t gradientStepOf(const gradientDda& d, int32_t k) {
+        return ((int32_t) d.gr->stops[k].pos * d.last + GRADIENT_POS_ONE / 2) / GRADIENT_POS_ONE;
+    }
+
+    inline void gradientChannels(const gradientStop& s, int32_t& r, int32_t& g, int32_t& b) {
+        r = ((int32_t) s.r * 31 << 16) / 255;
+        g = ((int32_t) s.g * 63 << 16) / 255;
+        b = ((int32_t) s.b * 31 << 16) / 255;
+    }
+
+    // Moves the walk to step i, setting up the segment that contains it
+    inline void gradientSeek(gradientDda& d, int32_t i) {
+        const gradient& gr = *d.gr;
+        int32_t seg = 0;
+        while (seg < gr.count && gradientStepOf(d, seg) <= i) {
+            seg++;
+        }
+        d.i = i;
+        d.dr = 0;
+        d.dg = 0;
+        d.db = 0;
+        if (seg == 0) {
+            gradientChannels(gr.stops[0], d.r, d.g, d.b);
+            d.end = gradientStepOf(d, 0);
+        } else if (seg == gr.count) {
+            gradientChannels(gr.stops[gr.count - 1], d.r, d.g, d.b);
+            d.end = INT32_MAX;
+        } else {
+            int32_t s0 = gradientStepOf(d, seg - 1);
+            int32_t r1, g1, b1;
+            d.end = gradientStepOf(d, seg);
+            gradientChannels(gr.stops[seg - 1], d.r, d.g, d.b);
+            gradientChannels(gr.stops[seg], r1, g1, b1);
+            d.dr = (r1 - d.r) / (d.end - s0);
+            d.dg = (g1 - d.g) / (d.end - s0);
+            d.db = (b1 - d.b) / (d.end - s0);
+            d.r += d.dr * (i - s0);
+            d.g += d.dg * (i - s0);
+            d.b += d.db * (i - s0);
+        }
+    }
+
+    inline void gradientBegin(gradientDda& d, const gradient& gr, int32_t length, int32_t i) {
+        d.gr = &gr;
+        d.last = length > 1 ? length - 1 : 0;
+        gradientSeek(d, i);
+    }
+
+    inline void gradientStep(gradientDda& d) {
+        if (++d.i >= d.end) {
+            gradientSeek(d, d.i);
+        } else {
+            d.r += d.dr;
+            d.g += d.dg;
+            d.b += d.db;
+        }
+    }
+
+    inline uint32_t gradientPacked(const gradientDda& d) {
+        return ((uint32_t) (d.r >> 10) << 21) | ((uint32_t) (d.g >> 11) << 10) | (uint32_t) (d.b >> 11);
+    }
+
+    // Packs count consecutive steps of a gradient, starting at step first,
+    // into steps
+    inline void gradientSample(const gradient& gr, int32_t length, int32_t first, int32_t count, uint32_t *steps) {
+        gradientDda d;
+        gradientBegin(d, gr, length, first);
+        for (int32_t i = 0; i < count; i++) {
+            steps[i] = gradientPacked(d);
+            gradientStep(d);
+        }
+    }
+
+    // Writes the pixels x0 <= x < x1 of a row, one gradient step per pixel
+    inline void gradientSpan(gradientDda& d, uint16_t *row, int32_t x0, int32_t x1, const uint32_t bias[4]) {
+        for (int32_t x = x0; x < x1; x++) {
+            row[x] = gradient565(gradientPacked(d) + bias[x & 3]);
+            gradientStep(d);
+        }
+    }
+
+    // Fills n pixels with a repeating four-pixel pattern, pattern[k] going to
+    // dst[k]
+    inline void gradientFillPattern(uint16_t *dst, int32_t n, const uint16_t pattern[4]) {
+        int32_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            dst[i] = pattern[0];
+            dst[i + 1] = pattern[1];
+            dst[i + 2] = pattern[2];
+            dst[i + 3] = pattern[3];
+        }
+        for (; i < n; i++) {
+            dst[i] = pattern[i & 3];
+        }
+    }
+
+    // The clipped area a gradient is drawn into. Rows are rendered straight
+    // into the canvas buffer; a rotated canvas gets gradientScratch instead,
+    // which is handed to Adafruit_GFX pixel by pixel once it is complete. So
+    // does an indexed canvas, which stores the palette entry nearest each
+    // pixel. Dithering happens before that match, so it only shows where the
+    // palette has entries close together (see paletteAddGradient).
+    struct gradientTarget {
+        Adafruit_GFX *canvas;
+        uint16_t *buffer;
+        paletteCanvas *indexed;
+        uint16_t *scratch;
+        int32_t x0;
+        int32_t y0;
+        int32_t x1;
+        int32_t y1;
+    };
+
+    inline bool gradientTargetClip(gradientTarget& t, int32_t x, int32_t y, int32_t w, int32_t h) {
+        Adafruit_GFX *canvas = t.canvas;
+        t.scratch = NULL;
+        t.x0 = x < 0 ? 0 : x;
+        t.y0 = y < 0 ? 0 : y;
+        t.x1 = x + w > canvas->width() ? canvas->width() : x + w;
+        t.y1 = y + h > canvas->height() ? canvas->height() : y + h;
+        if (t.x0 >= t.x1 || t.y0 >= t.y1) {
+            return false;
+        }
+        if (t.buffer == NULL) {
+            t.scratch = gradientScratch;
+            return canvas->width() <= JUN_GRADIENT_MAX_WIDTH;
+        }
+        return true;
+    }
+
+    inline bool gradientTargetBegin(gradientTarget& t, GFXcanvas16 *canvas, int32_t x, int32_t y, int32_t w, int32_t h) {
+        t.canvas = canvas;
+        t.buffer = canvas->getRotation() == 0 ? canvas->getBuffer() : NULL;
+        t.indexed = NULL;
+        return gradientTargetClip(t, x, y, w, h);
+    }
+
+    inline bool gradientTargetBegin(gradientTarget& t, paletteCanvas *canvas, int32_t x, int32_t y, int32_t w, int32_t h) {
+        t.canvas = canvas;
+        t.buffer = NULL;
+        t.indexed = canvas;
+        return gradientTargetClip(t, x, y, w, h);
+    }
+
+    inline uint16_t *gradientRow(gradientTarget& t, int32_t y) {
+        return t.scratch != NULL ? t.scratch : &t.buffer[y * t.canvas->width()];
+    }
+
+    inline void gradientRowDone(gradientTarget& t, int32_t y) {
+        if (t.indexed != NULL) {
+            t.indexed->writeNearest(t.x0, y, t.x1 - t.x0, &t.scratch[t.x0]);
+        } else if (t.scratch != NULL) {
+            for (int32_t x = t.x0; x < t.x1; x++) {
+                t.canvas->drawPixel(x, y, t.scratch[x]);
+            }
+        }
+    }
+
+    // Fills (x, y, w, h) with a linear gradient running from the top edge to
+    // the bottom, the left edge to the right, or the top left corner to the
+    // bottom right.
+    template<typename Canvas>
+    void gradientDrawLinear(Canvas *canvas, const gradient& gr, gradientAxis axis, int32_t x, int32_t y, int32_t w, int32_t h) {
+        gradientTarget t;
+        if (gr.count == 0 || !gradientTargetBegin(t, canvas, x, y, w, h)) {
+            return;
+        }
+        gradientDda d;
+        uint32_t bias[4];
+        int32_t n = t.x1 - t.x0;
+        switch (axis) {
+            case gradientAlongY:
+                // One colour per row, so dithering only picks between four
+                // precomputed pixels
+                gradientBegin(d, gr, h, t.y0 - y);
+                for (int32_t row = t.y0; row < t.y1; row++) {
+                    uint32_t c = gradientPacked(d);
+                    uint16_t *dst = gradientRow(t, row) + t.x0;
+                    if (gr.dither) {
+                        uint16_t pattern[4];
+                        gradientBias(gr, row, bias);
+                        for (int32_t k = 0; k < 4; k++) {
+                            pattern[k] = gradient565(c + bias[(t.x0 + k) & 3]);
+                        }
+                        gradientFillPattern(dst, n, pattern);
+                    } else {
+                        canvasFillSpan(dst, n, gradient565(c + gradientRound));
+                    }
+                    gradientRowDone(t, row);
+                    gradientStep(d);
+                }
+                break;
+            case gradientAlongX: {
+                // Every row matches the one a dither period above it, so only
+                // the first rows are computed
+                int32_t period = gr.dither ? 4 : 1;
+                for (int32_t row = t.y0; row < t.y1; row++) {
+                    uint16_t *dst = gradientRow(t, row);
+                    if (t.scratch == NULL && row - t.y0 >= period) {
+                        memcpy(dst + t.x0, dst - period * canvas->width() + t.x0, n * sizeof(uint16_t));
+                    } else {
+                        gradientBias(gr, row, bias);
+                        gradientBegin(d, gr, w, t.x0 - x);
+                        gradientSpan(d, dst, t.x0, t.x1, bias);
+                    }
+                    gradientRowDone(t, row);
+                }
+                break;
+            }
+            case gradientAlongDiagonal:
+                // Each row is the one above shifted by a step, so it starts
+                // one step further along
+                for (int32_t row = t.y0; row < t.y1; row++) {
+                    gradientBias(gr, row, bias);
+                    gradientBegin(d, gr, w + h - 1, (row - y) + (t.x0 - x));
+                    gradientSpan(d, gradientRow(t, row), t.x0, t.x1, bias);
+                    gradientRowDone(t, row);
+                }
+                break;
+        }
+    }
+
+    inline uint32_t gradientIsqrt(uint32_t v) {
+        uint32_t root = 0;
+        uint32_t bit = (uint32_t) 1 << 30;
+        while (bit > v) {
+            bit >>= 2;
+        }
+        while (bit != 0) {
+            if (v >= root + bit) {
+                v -= root + bit;
+                root = (root >> 1) + bit;
+            } else {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+        return root;
+    }
+
+    // The squared distance from (cx, cy) to (px, py), unsigned so that the
+    // squares cannot overflow
+    inline uint32_t gradientDist2(int32_t cx, int32_t cy, int32_t px, int32_t py) {
+        int32_t dx = px - cx;
+        int32_t dy = py - cy;
+        return (uint32_t) (dx * dx) + (uint32_t) (dy * dy);
+    }
+
+    // Fills (x, y, w, h) with a radial gradient centred on (cx, cy) that
+    // reaches its final stop at radius r. The colour of each ring the clipped
+    // area meets, from the nearest to the farthest, is computed once into
+    // gradientRings; across a row the distance to the centre is tracked
+    // incrementally from the squared distance, which changes by 2 dx + 1 per
+    // pixel.
+    template<typename Canvas>
+    void gradientDrawRadial(Canvas *canvas, const gradient& gr, int32_t x, int32_t y, int32_t w, int32_t h, int32_t cx, int32_t cy, int32_t r) {
+        gradientTarget t;
+        if (gr.count == 0 || r < 0 || !gradientTargetBegin(t, canvas, x, y, w, h)) {
+            return;
+        }
+        int32_t nearX = cx < t.x0 ? t.x0 : (cx >= t.x1 ? t.x1 - 1 : cx);
+        int32_t nearY = cy < t.y0 ? t.y0 : (cy >= t.y1 ? t.y1 - 1 : cy);
+        int32_t farX = cx - t.x0 > t.x1 - 1 - cx ? t.x0 : t.x1 - 1;
+        int32_t farY = cy - t.y0 > t.y1 - 1 - cy ? t.y0 : t.y1 - 1;
+        uint32_t nearest = gradientIsqrt(gradientDist2(cx, cy, nearX, nearY));
+        uint32_t farthest = gradientIsqrt(gradientDist2(cx, cy, farX, farY));
+        uint32_t first = nearest < (uint32_t) r ? nearest : r;
+        uint32_t last = farthest < (uint32_t) r ? farthest : r;
+        if (last - first >= GRADIENT_MAX_RINGS) {
+            return;
+        }
+        gradientSample(gr, r + 1, first, last - first + 1, gradientRings);
+        uint32_t bias[4];
+        for (int32_t row = t.y0; row < t.y1; row++) {
+            uint16_t *dst = gradientRow(t, row);
+            int32_t dx = t.x0 - cx;
+            // dist2 stays positive even though it is stepped by signed amounts
+            uint32_t dist2 = gradientDist2(cx, cy, t.x0, row);
+            uint32_t dist = gradientIsqrt(dist2);
+            uint32_t lo = dist * dist;
+            uint32_t hi = (dist + 1) * (dist + 1);
+            gradientBias(gr, row, bias);
+            for (int32_t px = t.x0; px < t.x1; px++) {
+                dst[px] = gradient565(gradientRings[(dist < (uint32_t) r ? dist : r) - first] + bias[px & 3]);
+                dist2 += (uint32_t) (2 * dx + 1);
+                dx++;
+                // Distance moves by at most one pixel per pixel
+                if (dist2 >= hi) {
+                    dist++;
+                    lo = hi;
+                    hi += 2 * dist + 1;
+                } else if (dist2 < lo) {
+                    dist--;
+                    hi = lo;
+                    lo -= 2 * dist + 1;
+                }
+            }
+            gradientRowDone(t, row);
+        }
+    }
+
+    // Adds n colours spaced evenly along a gradient to the palette of the
+    // indexed canvas, so that the gradient can be drawn into it without
+    // falling back on whatever colours happen to be there. Colours already
+    // in the palette are not added twice.
+    inline void paletteAddGradient(const gradient& gr, int32_t n) {
+        if (indexedCanvas == NULL || gr.count == 0 || n <= 0) {
+            return;
+        }
+        gradientDda d;
+        gradientBegin(d, gr, n, 0);
+        for (int32_t i = 0; i < n; i++) {
+            indexedCanvas->colorIndex(gradient565(gradientPacked(d) + gradientRound));
+            gradientStep(d);
+        }
+    }
+
+    // Renders a vertical gradient down the rows of the Arcada background
+    // layer. A background row holds a single colour, so it is never dithered.
+    // With an indexed canvas the palette starts over with half of it given to
+    // the background, which covers most of the screen.
+    inline void gradientBackground(const gradient& gr) {
+        if (backgroundRows == NULL || gr.count == 0) {
+            return;
+        }
+        if (indexedCanvas != NULL) {
+            indexedCanvas->paletteClear();
+            paletteAddGradient(gr, indexedCanvas->paletteCapacity() / 2);
+        }
+        int32_t h = canvasLayout()->height();
+        gradientDda d;
+        gradientBegin(d, gr, h, 0);
+        for (int32_t y = 0; y < h; y++) {
+            backgroundRows[y] = gradient565(gradientPacked(d) + gradientRound);
+            gradientStep(d);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef GFX_KERNELS_H
+#define GFX_KERNELS_H
+
+#include <Adafruit_GFX.h>
+#include "arcada_palette.h"
+#include "arcada_span.h"
+
+namespace arcada_gfx
+{
+    // Drawing kernels that write straight into the canvas buffer instead of
+    // going through Adafruit_GFX one virtual drawPixel at a time. Each
+    // primitive is clipped once and then filled span by span with
+    // canvasFillSpan. They produce exactly the pixels the Adafruit_GFX calls
+    // they replace would, which host/bench_gfx.cpp checks. Rotated canvases
+    // are left to Adafruit_GFX.
+    inline void kernelHLine(GFXcanvas16 *canvas, int32_t x, int32_t y, int32_t w, uint16_t c) {
+        if (canvas->getRotation() != 0) {
+            canvas->drawFastHLine(x, y, w, c);
+            return;
+        }
+        int32_t x1 = x + w;
+        if (y < 0 || y >= canvas->height() || w <= 0) {
+            return;
+        }
+        if (x < 0) {
+            x = 0;
+        }
+        if (x1 > canvas->width()) {
+            x1 = canvas->width();
+        }
+        if (x < x1) {
+            canvasFillSpan(&canvas->getBuffer()[y * canvas->width() + x], x1 - x, c);
+        }
+    }
+
+    inline void kernelFillRect(GFXcanvas16 *canvas, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t c) {
+        if (canvas->getRotation() != 0) {
+            canvas->fillRect(x, y, w, h, c);
+            return;
+        }
+        int32_t x1 = x + w;
+        int32_t y1 = y + h;
+        if (x < 0) {
+            x = 0;
+        }
+        if (y < 0) {
+            y = 0;
+        }
+        if (x1 > canvas->width()) {
+            x1 = canvas->width();
+        }
+        if (y1 > canvas->height()) {
+            y1 = canvas->height();
+        }
+        if (x >= x1 || y >= y1) {
+            return;
+        }
+        int32_t stride = canvas->width();
+        uint16_t *row = &canvas->getBuffer()[y * stride + x];
+        if (x == 0 && x1 == stride) {
+            // Full-width rows are one contiguous span
+            canvasFillSpan(row, (y1 - y) * stride, c);
+            return;
+        }
+        for (; y < y1; y++) {
+            canvasFillSpan(row, x1 - x, c);
+            row += stride;
+        }
+    }
+
+    inline void kernelPixel(GFXcanvas16 *canvas, int32_t x, int32_t y, uint16_t c) {
+        if (canvas->getRotation() != 0) {
+            canvas->drawPixel(x, y, c);
+            return;
+        }
+        if (x >= 0 && y >= 0 && x < canvas->width() && y < canvas->height()) {
+            canvas->getBuffer()[y * canvas->width() + x] = c;
+        }
+    }
+
+    // The same kernels for an indexed canvas, where c is a palette index.
+    // The canvas clips and fills its own spans a byte at a time.
+    inline void kernelHLine(paletteCanvas *canvas, int32_t x, int32_t y, int32_t w, uint16_t c) {
+        canvas->drawFastHLine(x, y, w, c);
+    }
+
+    inline void kernelFillRect(paletteCanvas *canvas, int32_t x, int32_t y, int32_t w, int32_t h, uint16_t c) {
+        canvas->fillRect(x, y, w, h, c);
+    }
+
+    inline void kernelPixel(paletteCanvas *canvas, int32_t x, int32_t y, uint16_t c) {
+        canvas->drawPixel(x, y, c);
+    }
+
+    // The colour a canvas stores for the RGB565 colour c: c itself, or a
+    // palette index
+    inline uint16_t canvasColor(GFXcanvas16 *canvas, uint16_t c) {
+        return c;
+    }
+
+    inline uint16_t canvasColor(paletteCanvas *canvas, uint16_t c) {
+        return canvas->colorIndex(c);
+    }
+
+    // Walks the same midpoint circle as Adafruit_GFX::fillCircle, but emits
+    // the mirrored horizontal spans instead of vertical lines. Adafruit's
+    // filled circle is symmetric about the diagonal, so the pixels match.
+    template<typename Canvas>
+    void kernelFillCircle(Canvas *canvas, int32_t x0, int32_t y0, int32_t r, uint16_t c) {
+        if (canvas->getRotation() != 0) {
+            canvas->fillCircle(x0, y0, r, c);
+            return;
+        }
+        kernelHLine(canvas, x0 - r, y0, 2 * r + 1, c);
+        int32_t f = 1 - r;
+        int32_t ddF_x = 1;
+        int32_t ddF_y = -2 * r;
+        int32_t x = 0;
+        int32_t y = r;
+        int32_t px = x;
+        int32_t py = y;
+        while (x < y) {
+            if (f >= 0) {
+                y--;
+                ddF_y += 2;
+                f += ddF_y;
+            }
+            x++;
+            ddF_x += 2;
+            f += ddF_x;
+            if (x < y + 1) {
+                kernelHLine(canvas, x0 - y, y0 + x, 2 * y + 1, c);
+                kernelHLine(canvas, x0 - y, y0 - x, 2 * y + 1, c);
+            }
+            if (y != py) {
+                kernelHLine(canvas, x0 - px, y0 + py, 2 * px + 1, c);
+                kernelHLine(canvas, x0 - px, y0 - py, 2 * px + 1, c);
+                py = y;
+            }
+            px = x;
+        }
+    }
+
+    template<typename Canvas>
+    void kernelDrawCircle(Canvas *canvas, int32_t x0, int32_t y0, int32_t r, uint16_t c) {
+        if (canvas->getRotation() != 0) {
+            canvas->drawCircle(x0, y0, r, c);
+            return;
+        }
+        int32_t f = 1 - r;
+        int32_t ddF_x = 1;
+        int32_t ddF_y = -2 * r;
+        int32_t x = 0;
+        int32_t y = r;
+        kernelPixel(canvas, x0, y0 + r, c);
+        kernelPixel(canvas, x0, y0 - r, c);
+        kernelPixel(canvas, x0 + r, y0, c);
+        kernelPixel(canvas, x0 - r, y0, c);
+        while (x < y) {
+            if (f >= 0) {
+                y--;
+                ddF_y += 2;
+                f += ddF_y;
+            }
+            x++;
+            ddF_x += 2;
+            f += ddF_x;
+            kernelPixel(canvas, x0 + x, y0 + y, c);
+            kernelPixel(canvas, x0 - x, y0 + y, c);
+            kernelPixel(canvas, x0 + x, y0 - y, c);
+            kernelPixel(canvas, x0 - x, y0 - y, c);
+            kernelPixel(canvas, x0 + y, y0 + x, c);
+            kernelPixel(canvas, x0 - y, y0 + x, c);
+            kernelPixel(canvas, x0 + y, y0 - x, c);
+            kernelPixel(canvas, x0 - y, y0 - x, c);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef GFX_OPS_H
+#define GFX_OPS_H
+
+#include "arcada_list.h"
+#include "gfx_gradient.h"
+
+namespace arcada_gfx
+{
+    // Drawing calls. Each op function below adds itself to the display list
+    // when calls are being recorded, or else draws straight into the canvas
+    // and damages what it covers; either way its replay function does the
+    // drawing. Replay functions are templates so that the same code draws
+    // into an indexed canvas.
+    inline void opDraw(listReplay replay, void (*indexed)(paletteCanvas *, int16_t, const void *), const void *args) {
+        if (indexedCanvas != NULL) {
+            indexed(indexedCanvas, 0, args);
+        } else {
+            replay(arcada.getCanvas(), 0, args);
+        }
+    }
+
+    struct rectArgs {
+        int16_t x;
+        int16_t y;
+        int16_t w;
+        int16_t h;
+        uint16_t c;
+    };
+
+    template<typename Canvas>
+    void replayFillRect(Canvas *canvas, int16_t dy, const void *args) {
+        const rectArgs& a = *(const rectArgs *) args;
+        kernelFillRect(canvas, a.x, a.y + dy, a.w, a.h, canvasColor(canvas, a.c));
+    }
+
+    inline void opFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t c) {
+        rectArgs a = { x, y, w, h, c };
+        if (!listRecord(replayFillRect, x, y, w, h, &a, sizeof(a))) {
+            opDraw(replayFillRect, replayFillRect, &a);
+            damageAdd(x, y, w, h);
+        }
+    }
+
+    template<typename Canvas>
+    void replayHLine(Canvas *canvas, int16_t dy, const void *args) {
+        const rectArgs& a = *(const rectArgs *) args;
+        kernelHLine(canvas, a.x, a.y + dy, a.w, canvasColor(canvas, a.c));
+    }
+
+    inline void opHLine(int16_t x, int16_t y, int16_t w, uint16_t c) {
+        rectArgs a = { x, y, w, 1, c };
+        if (!listRecord(replayHLine, x, y, w, 1, &a, sizeof(a))) {
+            opDraw(replayHLine, replayHLine, &a);
+            damageAdd(x, y, w, 1);
+        }
+    }
+
+    template<typename Canvas>
+    void replayPixel(Canvas *canvas, int16_t dy, const void *args) {
+        const rectArgs& a = *(const rectArgs *) args;
+        kernelPixel(canvas, a.x, a.y + dy, canvasColor(canvas, a.c));
+    }
+
+    inline void opPixel(int16_t x, int16_t y, uint16_t c) {
+        rectArgs a = { x, y, 1, 1, c };
+        if (!listRecord(replayPixel, x, y, 1, 1, &a, sizeof(a))) {
+            opDraw(replayPixel, replayPixel, &a);
+            damageAdd(x, y, 1, 1);
+        }
+    }
+
+    struct circleArgs {
+        int16_t x0;
+        int16_t y0;
+        int16_t r;
+        uint16_t c;
+    };
+
+    template<typename Canvas>
+    void replayFillCircle(Canvas *canvas, int16_t dy, const void *args) {
+        const circleArgs& a = *(const circleArgs *) args;
+        kernelFillCircle(canvas, a.x0, a.y0 + dy, a.r, canvasColor(canvas, a.c));
+    }
+
+    inline void opFillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t c) {
+        circleArgs a = { x0, y0, r, c };
+        if (!listRecord(replayFillCircle, (int32_t) x0 - r, (int32_t) y0 - r, 2 * r + 1, 2 * r + 1, &a, sizeof(a))) {
+            opDraw(replayFillCircle, replayFillCircle, &a);
+            damageAdd((int32_t) x0 - r, (int32_t) y0 - r, 2 * r + 1, 2 * r + 1);
+        }
+    }
+
+    template<typename Canvas>
+    void replayDrawCircle(Canvas *canvas, int16_t dy, const void *args) {
+        const circleArgs& a = *(const circleArgs *) args;
+        kernelDrawCircle(canvas, a.x0, a.y0 + dy, a.r, canvasColor(canvas, a.c));
+    }
+
+    inline void opDrawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t c) {
+        circleArgs a = { x0, y0, r, c };
+        if (!listRecord(replayDrawCircle, (int32_t) x0 - r, (int32_t) y0 - r, 2 * r + 1, 2 * r + 1, &a, sizeof(a))) {
+            opDraw(replayDrawCircle, replayDrawCircle, &a);
+            damageAdd((int32_t) x0 - r, (int32_t) y0 - r, 2 * r + 1, 2 * r + 1);
+        }
+    }
+
+    struct linearArgs {
+        gradient gr;
+        int16_t x;
+        int16_t y;
+        int16_t w;
+        int16_t h;
+        uint8_t axis;
+    };
+
+    template<typename Canvas>
+    void replayLinear(Canvas *canvas, int16_t dy, const void *args) {
+        const linearArgs& a = *(const linearArgs *) args;
+        gradientDrawLinear(canvas, a.gr, (gradientAxis) a.axis, a.x, a.y + dy, a.w, a.h);
+    }
+
+    inline void opLinear(const gradient& gr, uint8_t axis, int16_t x, int16_t y, int16_t w, int16_t h) {
+        linearArgs a;
+        memset(&a, 0, sizeof(a));
+        memcpy(&a.gr, &gr, sizeof(gr));
+        a.x = x;
+        a.y = y;
+        a.w = w;
+        a.h = h;
+        a.axis = axis;
+        if (!listRecord(replayLinear, x, y, w, h, &a, sizeof(a))) {
+            opDraw(replayLinear, replayLinear, &a);
+            damageAdd(x, y, w, h);
+        }
+    }
+
+    struct radialArgs {
+        gradient gr;
+        int16_t x;
+        int16_t y;
+        int16_t w;
+        int16_t h;
+        int16_t cx;
+        int16_t cy;
+        int16_t r;
+    };
+
+    template<typename Canvas>
+    void replayRadial(Canvas *canvas, int16_t dy, const void *args) {
+        const radialArgs& a = *(const radialArgs *) args;
+        gradientDrawRadial(canvas, a.gr, a.x, a.y + dy, a.w, a.h, a.cx, a.cy + dy, a.r);
+    }
+
+    inline void opRadial(const gradient& gr, int16_t x, int16_t y, int16_t w, int16_t h, int16_t cx, int16_t cy, int16_t r) {
+        radialArgs a;
+        memset(&a, 0, sizeof(a));
+        memcpy(&a.gr, &gr, sizeof(gr));
+        a.x = x;
+        a.y = y;
+        a.w = w;
+        a.h = h;
+        a.cx = cx;
+        a.cy = cy;
+        a.r = r;
+        if (!listRecord(replayRadial, x, y, w, h, &a, sizeof(a))) {
+            opDraw(replayRadial, replayRadial, &a);
+            damageAdd(x, y, w, h);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef JUNIPER_ATOMIC_H
+#define JUNIPER_ATOMIC_H
+
+// CWatch pulls this in with include(), which the compiler emits after the
+// Juniper runtime.
+#include <inttypes.h>
+
+#if !defined(__ARM_ARCH_7M__) && !defined(__ARM_ARCH_7EM__)
+#include <atomic>
+#endif
+
+// Reference counting that is safe against interrupts. The count of a
+// refcell is a plain int, which an interrupt or a BLE callback that copies
+// or drops the cell while loop() is doing the same can corrupt.
+// atomic_refcell<T> is a refcell whose count is an atomic_count: on
+// Cortex-M3/M4 a retried LDREX/STREX, elsewhere a std::atomic. Only the
+// cells actually shared with a callback need one, so the rest keep the
+// cheaper plain count:
+//
+//     juniper::atomic_refcell<reading> latest(reading{});
+//
+//     void onWrite(...) {
+//         juniper::atomic_refcell<reading> mine = latest;
+//         ...
+//     }
+//
+// Only the count is made safe. The callback has to hold a copy of its own
+// rather than share one atomic_refcell object with loop(), and the last
+// copy should be dropped outside the callback, since delete may not be
+// called from an interrupt.
+namespace juniper
+{
+    struct atomic_count {
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+        volatile int value;
+
+        explicit atomic_count(int init)
+            : value(init) {}
+
+        // An interrupt between the LDREX and the STREX clears the
+        // exclusive monitor, so the store fails and the add is retried
+        int add(int delta) {
+            int result;
+            int failed;
+            do {
+                __asm__ volatile("ldrex %0, [%1]" : "=r"(result) : "r"(&value) : "memory");
+                result += delta;
+                __asm__ volatile("strex %0, %2, [%1]" : "=&r"(failed) : "r"(&value), "r"(result) : "memory");
+            } while (failed);
+            return result;
+        }
+
+        void increment() {
+            add(1);
+        }
+
+        int decrement() {
+            return add(-1);
+        }
+#else
+        std::atomic<int> value;
+
+        explicit atomic_count(int init)
+            : value(init) {}
+
+        void increment() {
+            value.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        int decrement() {
+            return value.fetch_sub(1, std::memory_order_acq_rel) - 1;
+        }
+#endif
+    };
+
+    template<typename contained>
+    class atomic_refcell {
+    private:
+        struct cell {
+            atomic_count ref_count;
+            contained data;
+
+            cell(const contained& init_data)
+                : ref_count(1), data(init_data) {}
+        };
+
+        cell* content;
+
+        void inc_ref() {
+            if (content != nullptr) {
+                content->ref_count.increment();
+            }
+        }
+
+        void dec_ref() {
+            if (content != nullptr && content->ref_count.decrement() <= 0) {
+                delete content;
+            }
+            content = nullptr;
+        }
+
+    public:
+        atomic_refcell()
+            : content(nullptr)
+        {
+        }
+
+        atomic_refcell(contained init_data)
+            : content(new cell(init_data))
+        {
+        }
+
+        atomic_refcell(const atomic_refcell& rhs)
+            : content(rhs.content)
+        {
+            inc_ref();
+        }
+
+        atomic_refcell(atomic_refcell&& dyingObj)
+            : content(dyingObj.content)
+        {
+            dyingObj.content = nullptr;
+        }
+
+        ~atomic_refcell()
+        {
+            dec_ref();
+        }
+
+        contained* get() {
+            return content != nullptr ? &content->data : nullptr;
+        }
+
+        const contained* get() const {
+            return content != nullptr ? &content->data : nullptr;
+        }
+
+        // The new content is counted before the old is dropped, so
+        // assigning a cell to itself keeps it
+        atomic_refcell& operator=(const atomic_refcell& rhs) {
+            cell* old = content;
+            content = rhs.content;
+            inc_ref();
+            if (old != nullptr && old->ref_count.decrement() <= 0) {
+                delete old;
+            }
+            return *this;
+        }
+
+        atomic_refcell& operator=(atomic_refcell&& dyingObj) {
+            if (this != &dyingObj) {
+                dec_ref();
+                content = dyingObj.content;
+                dyingObj.content = nullptr;
+            }
+            return *this;
+        }
+
+        // Two cells are equal if they point to the same data
+        bool operator==(const atomic_refcell& rhs) const {
+            return content == rhs.content;
+        }
+
+        bool operator!=(const atomic_refcell& rhs) const {
+            return content != rhs.content;
+        }
+    };
+}
+
+#endif
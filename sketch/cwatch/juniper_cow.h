@@ -0,0 +1,216 @@
+#ifndef JUNIPER_COW_H
+#define JUNIPER_COW_H
+
+// CWatch pulls this in with include(), which the compiler emits after the
+// Juniper runtime whose arrays and lists it converts from and to.
+#include <inttypes.h>
+#include <string.h>
+#include <new>
+
+// Copy-on-write arrays and lists, for large values that are passed around
+// far more often than they are changed, such as sensor histories. A
+// cow_array keeps its elements in a reference-counted block that copies
+// share, so passing one by value costs a pointer and a count. Reads never
+// copy: an array with no block yet reads as zeros, from one zeroed element
+// rather than an allocation. Writes go through data(), which copies the
+// block first if another array shares it, so a run of writes pays for the
+// check once:
+//
+//     int32_t *items = history.data.data();
+//     for (uint32_t i = 0; i < n; i++) {
+//         items[i] = ...;
+//     }
+//
+// The pointer is good until the array is next copied or assigned, since a
+// copy shares the block again. The count is a plain int, so like refcell a
+// cow_array must not be copied or dropped from an interrupt.
+//
+// cow_list has the data and length of a Prelude::list and converts to and
+// from one, so the List functions accept it. They take their lists by
+// value, so each such call copies the elements out; keep the cow_list for
+// the functions of your own that pass it along.
+namespace juniper
+{
+    template<typename T, size_t N>
+    class cow_array {
+    private:
+        struct block {
+            int refs;
+            T items[N];
+        };
+
+        block* storage;
+
+        // A block of zeroed elements, as zeros() makes them
+        static block* allocate_zeroed() {
+            block* b = static_cast<block*>(::operator new(sizeof(block)));
+            memset((void *) b, 0, sizeof(block));
+            b->refs = 1;
+            return b;
+        }
+
+        static const T& zero() {
+            alignas(T) static const unsigned char bytes[sizeof(T)] = {};
+            return *reinterpret_cast<const T*>(bytes);
+        }
+
+        void release() {
+            if (storage != nullptr && --storage->refs <= 0) {
+                for (size_t i = 0; i < N; i++) {
+                    storage->items[i].~T();
+                }
+                ::operator delete(storage);
+            }
+            storage = nullptr;
+        }
+
+    public:
+        cow_array()
+            : storage(nullptr)
+        {
+        }
+
+        // Copies the elements of a runtime array into a block of their own
+        cow_array(const array<T, N>& rhs)
+            : storage(static_cast<block*>(::operator new(sizeof(block))))
+        {
+            storage->refs = 1;
+            for (size_t i = 0; i < N; i++) {
+                new (&storage->items[i]) T(rhs.data[i]);
+            }
+        }
+
+        cow_array(const cow_array& rhs)
+            : storage(rhs.storage)
+        {
+            if (storage != nullptr) {
+                storage->refs++;
+            }
+        }
+
+        ~cow_array() {
+            release();
+        }
+
+        cow_array& operator=(const cow_array& rhs) {
+            if (rhs.storage != nullptr) {
+                rhs.storage->refs++;
+            }
+            release();
+            storage = rhs.storage;
+            return *this;
+        }
+
+        const T& operator[](size_t i) const {
+            return storage != nullptr ? storage->items[i] : zero();
+        }
+
+        // The elements to write to, made this array's own first
+        T* data() {
+            if (storage == nullptr) {
+                storage = allocate_zeroed();
+            } else if (storage->refs > 1) {
+                block* b = static_cast<block*>(::operator new(sizeof(block)));
+                b->refs = 1;
+                for (size_t i = 0; i < N; i++) {
+                    new (&b->items[i]) T(storage->items[i]);
+                }
+                release();
+                storage = b;
+            }
+            return storage->items;
+        }
+
+        cow_array& fill(const T& fillWith) {
+            T* items = data();
+            for (size_t i = 0; i < N; i++) {
+                items[i] = fillWith;
+            }
+            return *this;
+        }
+
+        // Zeroes the elements from index from on. An array with no block is
+        // zeros already and keeps none.
+        cow_array& zero_from(size_t from) {
+            if (from < N && storage != nullptr) {
+                memset((void *) &data()[from], 0, (N - from) * sizeof(T));
+            }
+            return *this;
+        }
+
+        // Whether another array shares this one's block
+        bool shared() const {
+            return storage != nullptr && storage->refs > 1;
+        }
+
+        array<T, N> to_array() const {
+            array<T, N> ret;
+            if (storage == nullptr) {
+                memset((void *) &ret.data[0], 0, sizeof(ret.data));
+            } else {
+                for (size_t i = 0; i < N; i++) {
+                    ret.data[i] = storage->items[i];
+                }
+            }
+            return ret;
+        }
+
+        bool operator==(const cow_array& rhs) const {
+            if (storage == rhs.storage) {
+                return true;
+            }
+            for (size_t i = 0; i < N; i++) {
+                if (!((*this)[i] == rhs[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool operator!=(const cow_array& rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+    template<typename T, size_t N>
+    struct cow_list {
+        cow_array<T, N> data;
+        uint32_t length;
+
+        cow_list()
+            : length(0)
+        {
+        }
+
+        cow_list(const cow_array<T, N>& init_data, uint32_t init_length)
+            : data(init_data), length(init_length)
+        {
+        }
+
+        // From a Prelude::list, the record the compiler makes of an array
+        // and a length
+        template<template<typename, typename> class R>
+        cow_list(const R<array<T, N>, uint32_t>& rhs)
+            : data(rhs.data), length(rhs.length)
+        {
+        }
+
+        template<template<typename, typename> class R>
+        operator R<array<T, N>, uint32_t>() const {
+            R<array<T, N>, uint32_t> ret;
+            ret.data = data.to_array();
+            ret.length = length;
+            return ret;
+        }
+
+        bool operator==(const cow_list& rhs) const {
+            return length == rhs.length && data == rhs.data;
+        }
+
+        bool operator!=(const cow_list& rhs) const {
+            return !(*this == rhs);
+        }
+    };
+}
+
+#endif
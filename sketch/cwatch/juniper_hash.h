@@ -0,0 +1,193 @@
+#ifndef JUNIPER_HASH_H
+#define JUNIPER_HASH_H
+
+// CWatch pulls this in with include(), which the compiler emits after the
+// Juniper runtime. It finds its way around the generated types the same
+// way juniper::binary does, and hashes a record by the fields described
+// for it there.
+#include <inttypes.h>
+#include <string.h>
+#include "juniper_binary.h"
+
+// juniper::hash(v) hashes a runtime value so that values equal under ==
+// hash equal, for hash tables and cheap change detection:
+// - integers, enums and pointers hash their mixed value;
+// - floats hash their bits, with -0.0 hashed like 0.0;
+// - arrays, tuples and the variants behind maybes and ADTs combine the
+//   hashes of their parts, and a list those of its length and the
+//   elements in use;
+// - a record described with a juniper::binary::fields specialisation
+//   combines the hashes of the fields listed, and any other record hashes
+//   its bytes, provided it has no padding or floats that could make equal
+//   values differ in memory.
+// Specialise hasher for other types.
+namespace juniper
+{
+    inline uint32_t hash_mix(uint32_t h) {
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    inline uint32_t hash_combine(uint32_t seed, uint32_t h) {
+        return seed ^ (h + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+    }
+
+    template<typename T, typename = void>
+    struct hasher;
+
+    template<typename T>
+    uint32_t hash(const T& v) {
+        return hasher<T>::hash(v);
+    }
+
+    template<typename T>
+    struct hasher<T, typename binary::enable_if<!__is_class(T) && !__is_union(T)>::type> {
+        static uint32_t hash(const T& v) {
+            uint64_t bits = (uint64_t) v;
+            return hash_mix((uint32_t) bits ^ (uint32_t) (bits >> 32));
+        }
+    };
+
+    // 0.0 and -0.0 are equal, so they hash alike
+    template<>
+    struct hasher<float> {
+        static uint32_t hash(const float& v) {
+            uint32_t bits = 0;
+            if (v != 0.0f) {
+                memcpy(&bits, &v, sizeof(bits));
+            }
+            return hash_mix(bits);
+        }
+    };
+
+    template<>
+    struct hasher<double> {
+        static uint32_t hash(const double& v) {
+            uint64_t bits = 0;
+            if (v != 0.0) {
+                memcpy(&bits, &v, sizeof(bits));
+            }
+            return hash_mix((uint32_t) bits ^ (uint32_t) (bits >> 32));
+        }
+    };
+
+    template<>
+    struct hasher<unit> {
+        static uint32_t hash(const unit& v) {
+            return 0;
+        }
+    };
+
+    template<typename T, size_t N>
+    struct hasher<array<T, N>> {
+        static uint32_t hash(const array<T, N>& v) {
+            uint32_t h = 0;
+            for (size_t i = 0; i < N; i++) {
+                h = hash_combine(h, juniper::hash(v.data[i]));
+            }
+            return h;
+        }
+    };
+
+    // The alternative a variant holds, found as juniper::binary finds it.
+    // The runtime's id and get have no const overloads.
+    template<unsigned char n, typename... Ts>
+    struct variant_hasher;
+
+    template<unsigned char n, typename F, typename... Ts>
+    struct variant_hasher<n, F, Ts...> {
+        template<typename V>
+        static uint32_t hash(unsigned char id, const V& v) {
+            if (id == n) {
+                return juniper::hash(const_cast<V&>(v).template get<n>());
+            }
+            return variant_hasher<n + 1, Ts...>::hash(id, v);
+        }
+    };
+
+    template<unsigned char n>
+    struct variant_hasher<n> {
+        template<typename V>
+        static uint32_t hash(unsigned char id, const V& v) {
+            return 0;
+        }
+    };
+
+    template<typename... Ts>
+    struct hasher<variant<Ts...>> {
+        static uint32_t hash(const variant<Ts...>& v) {
+            unsigned char id = const_cast<variant<Ts...>&>(v).id();
+            return hash_combine(id, variant_hasher<0, Ts...>::hash(id, v));
+        }
+    };
+
+    template<typename... Fs>
+    struct field_hasher;
+
+    template<>
+    struct field_hasher<> {
+        template<typename R>
+        static uint32_t hash(const R& r) {
+            return 0;
+        }
+    };
+
+    template<typename F, typename... Fs>
+    struct field_hasher<F, Fs...> {
+        template<typename R>
+        static uint32_t hash(const R& r) {
+            return hash_combine(juniper::hash(F::of(r)), field_hasher<Fs...>::hash(r));
+        }
+    };
+
+    template<typename List>
+    struct list_hasher;
+
+    template<typename... Fs>
+    struct list_hasher<binary::field_list<Fs...>> : field_hasher<Fs...> {};
+
+    template<typename T>
+    struct hasher<T, typename binary::enable_if<binary::shape<T>::record>::type> {
+        static uint32_t hash(const T& v) {
+            return list_hasher<typename binary::fields<T>::list>::hash(v);
+        }
+    };
+
+    template<typename T>
+    struct hasher<T, typename binary::enable_if<binary::shape<T>::plain && __has_unique_object_representations(T)>::type> {
+        static uint32_t hash(const T& v) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&v);
+            uint32_t h = 0;
+            for (size_t i = 0; i < sizeof(T); i++) {
+                h = h * 31 + bytes[i];
+            }
+            return hash_mix(h);
+        }
+    };
+
+    template<typename T>
+    struct hasher<T, typename binary::enable_if<binary::shape<T>::list>::type> {
+        typedef binary::is_array<typename binary::shape<T>::data> array_t;
+
+        static uint32_t hash(const T& v) {
+            uint32_t h = juniper::hash(v.length);
+            for (uint32_t i = 0; i < v.length && i < array_t::capacity; i++) {
+                h = hash_combine(h, juniper::hash(v.data.data[i]));
+            }
+            return h;
+        }
+    };
+
+    template<typename T>
+    struct hasher<T, typename binary::enable_if<binary::shape<T>::adt>::type> {
+        static uint32_t hash(const T& v) {
+            return juniper::hash(v.data);
+        }
+    };
+}
+
+#endif
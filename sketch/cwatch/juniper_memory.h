@@ -0,0 +1,536 @@
+#ifndef JUNIPER_MEMORY_H
+#define JUNIPER_MEMORY_H
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <new>
+
+// CWatch includes this for frame_begin, frame_end, format and
+// format_allocations. Defining JUN_CELL_POOLS or JUN_ALLOC_TRACK replaces
+// the global operator new and delete, and replacement operators can only
+// be defined once in a program, so this header belongs to the file
+// holding the generated code and must not be included from any other.
+
+// Allocation of reference-counted cells. The runtime makes the cells
+// behind refcell and rcptr with new and frees them with delete, so
+// defining JUN_CELL_POOLS replaces the global operator new and delete
+// with ones that serve small blocks from fixed-block pools in four size
+// classes instead of the general heap, so that long-lived programs do not
+// fragment it. This takes in everything allocated with new, the
+// libraries' objects included; malloc and free are left alone. Each class
+// holds JUN_POOL_BLOCKS blocks unless JUN_POOL_BLOCKS_<size> says
+// otherwise. A block that does not fit a class, or finds its class full,
+// comes from malloc and is counted as an overflow.
+//
+// With JUN_FRAME_ARENA_BYTES set as well, blocks allocated between
+// frame_begin and frame_end (the start and end of loop) are
+// bump-allocated from an arena first. frame_end empties the arena once
+// none of its blocks is alive; a block that outlives its frame keeps the
+// arena from being reused until it is freed, and the frames this happens
+// in are counted as pinned.
+//
+// BLE callbacks run in tasks of their own, and on the host the present
+// thread runs beside loop(), so the pools and the arena are only touched
+// under a lock: a FreeRTOS critical section on the watch and a spinlock
+// on the host. new and delete must still not be called from an
+// interrupt.
+#if defined(JUN_CELL_POOLS) || defined(JUN_ALLOC_TRACK)
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef __arm__
+// For the FreeRTOS critical section
+#include <Arduino.h>
+#else
+#include <atomic>
+#endif
+#endif
+
+#ifdef JUN_CELL_POOLS
+
+#ifndef JUN_POOL_BLOCKS
+#define JUN_POOL_BLOCKS 16
+#endif
+
+#ifndef JUN_POOL_BLOCKS_16
+#define JUN_POOL_BLOCKS_16 JUN_POOL_BLOCKS
+#endif
+
+#ifndef JUN_POOL_BLOCKS_32
+#define JUN_POOL_BLOCKS_32 JUN_POOL_BLOCKS
+#endif
+
+#ifndef JUN_POOL_BLOCKS_64
+#define JUN_POOL_BLOCKS_64 JUN_POOL_BLOCKS
+#endif
+
+#ifndef JUN_POOL_BLOCKS_128
+#define JUN_POOL_BLOCKS_128 JUN_POOL_BLOCKS
+#endif
+
+#ifndef JUN_FRAME_ARENA_BYTES
+#define JUN_FRAME_ARENA_BYTES 0
+#endif
+#endif
+
+// Allocation tracking. Define JUN_ALLOC_TRACK to count every block
+// allocated with new, the cells behind refcell and rcptr and the blocks
+// behind arrays among them; without it the operators are not replaced
+// and nothing is counted. The generated code cannot say what type it is
+// allocating, so blocks are counted by their size instead, which for the
+// runtime's cells tells the record types apart well enough. The first
+// JUN_ALLOC_SIZES sizes seen each get their own counts and the rest share
+// one. Each size keeps its live count and bytes, the most bytes it has
+// had live at once, and how many it has ever allocated. The totals also
+// count the allocations made between frame_begin and frame_end, keeping
+// the last frame's count and the highest. format_allocations() writes
+// these out. On the host every size still live when the program exits is
+// printed to stderr; blocks held by globals show up there as well as
+// leaks. Each block carries its size in a header of block_align bytes in
+// front of it, so with JUN_CELL_POOLS as well blocks land in the class
+// above the one they would use untracked.
+#ifndef JUN_ALLOC_SIZES
+#define JUN_ALLOC_SIZES 16
+#endif
+
+namespace juniper
+{
+    namespace memory
+    {
+        // Every block new returns is aligned for any type
+        const size_t block_align = alignof(max_align_t);
+
+#if defined(JUN_CELL_POOLS) || defined(JUN_ALLOC_TRACK)
+        // Held while the pools, the arena or the counts change
+        struct pool_lock {
+#ifdef __arm__
+            pool_lock() {
+                taskENTER_CRITICAL();
+            }
+
+            ~pool_lock() {
+                taskEXIT_CRITICAL();
+            }
+#else
+            static std::atomic_flag& flag() {
+                static std::atomic_flag held = ATOMIC_FLAG_INIT;
+                return held;
+            }
+
+            pool_lock() {
+                while (flag().test_and_set(std::memory_order_acquire)) {
+                }
+            }
+
+            ~pool_lock() {
+                flag().clear(std::memory_order_release);
+            }
+#endif
+        };
+#endif
+
+#ifdef JUN_ALLOC_TRACK
+        struct size_stats {
+            uint32_t size;
+            uint32_t live;
+            uint32_t live_bytes;
+            uint32_t peak_bytes;
+            uint32_t allocations;
+        };
+
+        struct allocation_totals {
+            uint32_t live;
+            uint32_t live_bytes;
+            uint32_t peak_bytes;
+            uint32_t allocations;
+            uint32_t frame_allocations;
+            uint32_t last_frame_allocations;
+            uint32_t peak_frame_allocations;
+        };
+
+        static allocation_totals totals;
+
+        // One entry per size and a last one shared by the sizes that came
+        // after the others were taken
+        static size_stats sizes[JUN_ALLOC_SIZES + 1];
+
+        // The entry counting blocks of size bytes. An entry that has never
+        // allocated is free and is taken for size.
+        inline size_stats& stats_for(size_t size) {
+            for (uint16_t i = 0; i < JUN_ALLOC_SIZES; i++) {
+                if (sizes[i].allocations == 0) {
+                    sizes[i].size = size;
+                    return sizes[i];
+                }
+                if (sizes[i].size == size) {
+                    return sizes[i];
+                }
+            }
+            return sizes[JUN_ALLOC_SIZES];
+        }
+
+#ifndef __arm__
+        inline void dump_leaks() {
+            for (uint16_t i = 0; i <= JUN_ALLOC_SIZES; i++) {
+                const size_stats& s = sizes[i];
+                if (s.live == 0) {
+                    continue;
+                }
+                if (i == JUN_ALLOC_SIZES) {
+                    fprintf(stderr, "leaked %lu blocks of other sizes (%lu bytes)\n",
+                        (unsigned long) s.live, (unsigned long) s.live_bytes);
+                } else {
+                    fprintf(stderr, "leaked %lu blocks of %lu bytes\n",
+                        (unsigned long) s.live, (unsigned long) s.size);
+                }
+            }
+        }
+#endif
+
+        // Called with the lock held
+        inline void note_allocate(size_t size) {
+#ifndef __arm__
+            if (totals.allocations == 0) {
+                atexit(dump_leaks);
+            }
+#endif
+            size_stats& s = stats_for(size);
+            s.live++;
+            s.live_bytes += size;
+            s.peak_bytes = s.live_bytes > s.peak_bytes ? s.live_bytes : s.peak_bytes;
+            s.allocations++;
+            totals.live++;
+            totals.live_bytes += size;
+            totals.peak_bytes = totals.live_bytes > totals.peak_bytes ? totals.live_bytes : totals.peak_bytes;
+            totals.allocations++;
+            totals.frame_allocations++;
+        }
+
+        inline void note_deallocate(size_t size) {
+            size_stats& s = stats_for(size);
+            s.live--;
+            s.live_bytes -= size;
+            totals.live--;
+            totals.live_bytes -= size;
+        }
+
+        inline void note_frame_begin() {
+            totals.frame_allocations = 0;
+        }
+
+        inline void note_frame_end() {
+            uint32_t n = totals.frame_allocations;
+            totals.last_frame_allocations = n;
+            totals.peak_frame_allocations = n > totals.peak_frame_allocations ? n : totals.peak_frame_allocations;
+        }
+
+        // Writes a line for the totals and one per size with blocks live:
+        //   alloc live bytes peak allocations last_frame peak_frame
+        //   size bytes live bytes peak allocations
+        // The shared entry is written with other for its size. Output that
+        // does not fit in len (at least 1) is cut short. Returns the
+        // length written.
+        inline size_t format_allocations(char *buf, size_t len) {
+            size_t used = snprintf(buf, len, "alloc %lu %lu %lu %lu %lu %lu\n",
+                (unsigned long) totals.live, (unsigned long) totals.live_bytes, (unsigned long) totals.peak_bytes,
+                (unsigned long) totals.allocations, (unsigned long) totals.last_frame_allocations,
+                (unsigned long) totals.peak_frame_allocations);
+            for (uint16_t i = 0; i <= JUN_ALLOC_SIZES && used < len; i++) {
+                const size_stats& s = sizes[i];
+                if (s.live == 0) {
+                    continue;
+                }
+                char size[12];
+                if (i == JUN_ALLOC_SIZES) {
+                    snprintf(size, sizeof(size), "other");
+                } else {
+                    snprintf(size, sizeof(size), "%lu", (unsigned long) s.size);
+                }
+                used += snprintf(buf + used, len - used, "size %s %lu %lu %lu %lu\n",
+                    size, (unsigned long) s.live, (unsigned long) s.live_bytes,
+                    (unsigned long) s.peak_bytes, (unsigned long) s.allocations);
+            }
+            return used < len ? used : len - 1;
+        }
+#else
+        inline size_t format_allocations(char *buf, size_t len) {
+            if (len > 0) {
+                buf[0] = '\0';
+            }
+            return 0;
+        }
+#endif
+    }
+}
+
+namespace juniper
+{
+    namespace memory
+    {
+#ifdef JUN_CELL_POOLS
+        // Blocks are handed out in address order until every one has been
+        // used once, and from a free list threaded through them after that
+        struct fixed_pool {
+            unsigned char *storage;
+            uint16_t block_size;
+            uint16_t capacity;
+            uint16_t carved;
+            void *free_list;
+            uint16_t live;
+            uint16_t high_water;
+            uint32_t allocations;
+            uint32_t overflows;
+
+            void *allocate() {
+                void *ptr;
+                if (free_list != nullptr) {
+                    ptr = free_list;
+                    free_list = *(void **) ptr;
+                } else if (carved < capacity) {
+                    ptr = storage + (size_t) carved++ * block_size;
+                } else {
+                    overflows++;
+                    return nullptr;
+                }
+                allocations++;
+                live++;
+                high_water = live > high_water ? live : high_water;
+                return ptr;
+            }
+
+            bool owns(const void *ptr) const {
+                uintptr_t p = (uintptr_t) ptr;
+                return p >= (uintptr_t) storage && p < (uintptr_t) storage + (size_t) capacity * block_size;
+            }
+
+            void deallocate(void *ptr) {
+                *(void **) ptr = free_list;
+                free_list = ptr;
+                live--;
+            }
+        };
+
+        struct frame_arena {
+            unsigned char *storage;
+            size_t capacity;
+            size_t used;
+            size_t high_water;
+            uint16_t live;
+            bool active;
+            uint32_t resets;
+            uint32_t pinned;
+
+            void *allocate(size_t size) {
+                size = (size + block_align - 1) & ~(block_align - 1);
+                if (!active || capacity - used < size) {
+                    return nullptr;
+                }
+                void *ptr = storage + used;
+                used += size;
+                high_water = used > high_water ? used : high_water;
+                live++;
+                return ptr;
+            }
+
+            bool owns(const void *ptr) const {
+                uintptr_t p = (uintptr_t) ptr;
+                return p >= (uintptr_t) storage && p < (uintptr_t) storage + capacity;
+            }
+        };
+
+#define JUN_POOL_STORAGE(blocks, size) ((blocks) > 0 ? (blocks) * (size) : 1)
+
+        alignas(block_align) static unsigned char pool_storage_16[JUN_POOL_STORAGE(JUN_POOL_BLOCKS_16, 16)];
+        alignas(block_align) static unsigned char pool_storage_32[JUN_POOL_STORAGE(JUN_POOL_BLOCKS_32, 32)];
+        alignas(block_align) static unsigned char pool_storage_64[JUN_POOL_STORAGE(JUN_POOL_BLOCKS_64, 64)];
+        alignas(block_align) static unsigned char pool_storage_128[JUN_POOL_STORAGE(JUN_POOL_BLOCKS_128, 128)];
+        alignas(block_align) static unsigned char arena_storage[JUN_POOL_STORAGE(JUN_FRAME_ARENA_BYTES, 1)];
+
+        static fixed_pool pools[] = {
+            { pool_storage_16, 16, JUN_POOL_BLOCKS_16, 0, nullptr, 0, 0, 0, 0 },
+            { pool_storage_32, 32, JUN_POOL_BLOCKS_32, 0, nullptr, 0, 0, 0, 0 },
+            { pool_storage_64, 64, JUN_POOL_BLOCKS_64, 0, nullptr, 0, 0, 0, 0 },
+            { pool_storage_128, 128, JUN_POOL_BLOCKS_128, 0, nullptr, 0, 0, 0, 0 }
+        };
+
+        const uint8_t pool_count = sizeof(pools) / sizeof(pools[0]);
+
+        static frame_arena arena = { arena_storage, JUN_FRAME_ARENA_BYTES, 0, 0, 0, false, 0, 0 };
+
+        // Blocks too large for any class
+        static uint32_t oversize = 0;
+
+        // The arena while a frame is running, then the smallest class the
+        // block fits, then malloc. Like the Arduino core's operator new this
+        // returns NULL once the heap is exhausted.
+        inline void *allocate_block(size_t size) {
+            {
+                pool_lock held;
+                void *ptr = arena.allocate(size);
+                if (ptr != nullptr) {
+                    return ptr;
+                }
+                uint8_t i = 0;
+                while (i < pool_count && size > pools[i].block_size) {
+                    i++;
+                }
+                if (i == pool_count) {
+                    oversize++;
+                } else if ((ptr = pools[i].allocate()) != nullptr) {
+                    return ptr;
+                }
+            }
+            return malloc(size > 0 ? size : 1);
+        }
+
+        inline void deallocate_block(void *ptr) {
+            {
+                pool_lock held;
+                if (arena.owns(ptr)) {
+                    arena.live--;
+                    return;
+                }
+                for (uint8_t i = 0; i < pool_count; i++) {
+                    if (pools[i].owns(ptr)) {
+                        pools[i].deallocate(ptr);
+                        return;
+                    }
+                }
+            }
+            free(ptr);
+        }
+
+        // Writes one line per size class and one for the arena:
+        //   pool size live high capacity allocations overflows
+        //   arena used high capacity resets pinned
+        // Output that does not fit in len (at least 1) is cut short.
+        // Returns the length written.
+        inline size_t format(char *buf, size_t len) {
+            size_t used = 0;
+            buf[0] = '\0';
+            for (uint8_t i = 0; i < pool_count && used < len; i++) {
+                const fixed_pool& pool = pools[i];
+                used += snprintf(buf + used, len - used, "pool %u %u %u %u %lu %lu\n",
+                    (unsigned) pool.block_size, (unsigned) pool.live, (unsigned) pool.high_water,
+                    (unsigned) pool.capacity, (unsigned long) pool.allocations, (unsigned long) pool.overflows);
+            }
+            if (used < len && arena.capacity > 0) {
+                used += snprintf(buf + used, len - used, "arena %lu %lu %lu %lu %lu\n",
+                    (unsigned long) arena.used, (unsigned long) arena.high_water, (unsigned long) arena.capacity,
+                    (unsigned long) arena.resets, (unsigned long) arena.pinned);
+            }
+            return used < len ? used : len - 1;
+        }
+#else
+        inline size_t format(char *buf, size_t len) {
+            if (len > 0) {
+                buf[0] = '\0';
+            }
+            return 0;
+        }
+#endif
+
+#if defined(JUN_ALLOC_TRACK) && !defined(JUN_CELL_POOLS)
+        inline void *allocate_block(size_t size) {
+            return malloc(size > 0 ? size : 1);
+        }
+
+        inline void deallocate_block(void *ptr) {
+            free(ptr);
+        }
+#endif
+
+#if defined(JUN_CELL_POOLS) || defined(JUN_ALLOC_TRACK)
+        // What operator new and delete do
+        inline void *allocate(size_t size) {
+#ifdef JUN_ALLOC_TRACK
+            unsigned char *block = (unsigned char *) allocate_block(block_align + size);
+            if (block == nullptr) {
+                return nullptr;
+            }
+            *(size_t *) block = size;
+            pool_lock held;
+            note_allocate(size);
+            return block + block_align;
+#else
+            return allocate_block(size);
+#endif
+        }
+
+        inline void deallocate(void *ptr) {
+            if (ptr == nullptr) {
+                return;
+            }
+#ifdef JUN_ALLOC_TRACK
+            unsigned char *block = (unsigned char *) ptr - block_align;
+            {
+                pool_lock held;
+                note_deallocate(*(size_t *) block);
+            }
+            deallocate_block(block);
+#else
+            deallocate_block(ptr);
+#endif
+        }
+#endif
+
+        inline void frame_begin() {
+#if defined(JUN_CELL_POOLS) || defined(JUN_ALLOC_TRACK)
+            pool_lock held;
+#endif
+#ifdef JUN_ALLOC_TRACK
+            note_frame_begin();
+#endif
+#ifdef JUN_CELL_POOLS
+            arena.active = arena.capacity > 0;
+#endif
+        }
+
+        inline void frame_end() {
+#if defined(JUN_CELL_POOLS) || defined(JUN_ALLOC_TRACK)
+            pool_lock held;
+#endif
+#ifdef JUN_ALLOC_TRACK
+            note_frame_end();
+#endif
+#ifdef JUN_CELL_POOLS
+            arena.active = false;
+            if (arena.live == 0) {
+                arena.used = 0;
+                arena.resets++;
+            } else {
+                arena.pinned++;
+            }
+#endif
+        }
+    }
+}
+
+#if defined(JUN_CELL_POOLS) || defined(JUN_ALLOC_TRACK)
+void *operator new(size_t size) {
+    return juniper::memory::allocate(size);
+}
+
+void *operator new[](size_t size) {
+    return juniper::memory::allocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    juniper::memory::deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    juniper::memory::deallocate(ptr);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *ptr, size_t size) noexcept {
+    juniper::memory::deallocate(ptr);
+}
+
+void operator delete[](void *ptr, size_t size) noexcept {
+    juniper::memory::deallocate(ptr);
+}
+#endif
+#endif
+
+#endif